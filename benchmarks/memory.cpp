@@ -0,0 +1,164 @@
+// SPDX-FileCopyrightText: 2024 Dennis Gläser <dennis.a.glaeser@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Measures the peak memory of converting data to python and rendering it, for different data sizes:
+//
+//     cpplot-memory-benchmark [MAX_ELEMENTS]
+//
+// For each case, two high-water marks relative to the state before the case are reported, also per input element:
+//   - the peak resident set size of the process (Linux only, requires resetting it via /proc/self/clear_refs),
+//   - the peak of memory traced by python's tracemalloc (python objects and numpy arrays).
+// Each case is run once per size, in a fresh figure that is closed afterwards. Note that the resident set size only
+// grows if a case needs more memory than the allocators retained from previous cases, while tracemalloc also sees
+// reused memory. Thus, the python peak is the more reproducible measure, while the rss peak detects OOM candidates.
+// Garbage and matplotlib's caches are cleared before and after each case, such that the results do not depend on the
+// order of the cases (each case thus includes the cost of refilling the caches it uses).
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <cmath>
+
+#include <cpplot/cpplot.hpp>
+#include <cpplot/python.hpp>
+
+namespace {
+
+std::size_t peak_resident_set_size() {
+#ifdef __linux__
+    std::ifstream status{"/proc/self/status"};
+    for (std::string line; std::getline(status, line); )
+        if (line.starts_with("VmHWM:"))
+            return std::stoul(line.substr(6))*1024;
+#endif
+    return 0;
+}
+
+bool reset_peak_resident_set_size() {
+#ifdef __linux__
+    std::ofstream clear_refs{"/proc/self/clear_refs"};
+    return static_cast<bool>(clear_refs << "5" << std::flush);
+#else
+    return false;
+#endif
+}
+
+struct measurement {
+    long long rss_peak;
+    long long python_peak;
+};
+
+measurement measure(const std::function<void()>& action) {
+    using cpplot::detail::pycall;
+    using cpplot::no_args;
+    static const cpplot::pyobject tracemalloc = cpplot::pyobject::from(PyImport_ImportModule("tracemalloc"));
+    const auto traced = [&] () {
+        return cpplot::detail::from_pyobject<std::tuple<long long, long long>>(pycall(tracemalloc, "get_traced_memory"));
+    };
+
+    // collect the (cyclic) garbage of previous cases, which would otherwise be freed during this one
+    cpplot::trim_memory();
+    pycall(tracemalloc, "reset_peak");
+    const auto python_before = std::get<0>(traced());
+    reset_peak_resident_set_size();
+    const auto rss_before = static_cast<long long>(cpplot::detail::resident_set_size());
+
+    action();
+
+    const auto python_peak = std::get<1>(traced());
+    const measurement result{
+        .rss_peak = std::max(static_cast<long long>(peak_resident_set_size()) - rss_before, 0ll),
+        .python_peak = python_peak - python_before
+    };
+    cpplot::trim_memory();
+    return result;
+}
+
+void report(const std::string& name, std::size_t elements, const measurement& m) {
+    const auto per_element = [&] (long long bytes) { return static_cast<double>(bytes)/static_cast<double>(elements); };
+    std::cout << std::left << std::setw(18) << name
+              << std::right << std::setw(12) << elements
+              << std::setw(16) << m.rss_peak
+              << std::setw(12) << std::fixed << std::setprecision(1) << per_element(m.rss_peak)
+              << std::setw(16) << m.python_peak
+              << std::setw(12) << per_element(m.python_peak)
+              << std::endl;
+}
+
+std::vector<double> make_values(std::size_t n) {
+    std::vector<double> values(n);
+    for (std::size_t i = 0; i < n; ++i)
+        values[i] = std::sin(static_cast<double>(i)*1e-3);
+    return values;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+    using namespace cpplot;
+    using namespace cpplot::literals;
+    const std::size_t max_elements = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+    // render once upfront such that one-time initialization (imports, font cache) does not distort the results
+    {
+        figure warm_up;
+        warm_up.axis().plot(std::vector{1.0, 2.0});
+        warm_up.save_to("memory_benchmark.png");
+        warm_up.close();
+    }
+    detail::pycall(pyobject::from(PyImport_ImportModule("tracemalloc")), "start");
+    if (!reset_peak_resident_set_size())
+        std::cout << "Note: cannot reset the peak resident set size, rss values are unreliable" << std::endl;
+
+    std::cout << std::left << std::setw(18) << "case"
+              << std::right << std::setw(12) << "elements"
+              << std::setw(16) << "rss peak [B]"
+              << std::setw(12) << "B/element"
+              << std::setw(16) << "py peak [B]"
+              << std::setw(12) << "B/element"
+              << std::endl;
+
+    for (std::size_t n = 1000; n <= max_elements; n *= 10) {
+        const auto values = make_values(n);
+        const auto side = static_cast<std::size_t>(std::sqrt(static_cast<double>(n)));
+        const std::vector<std::vector<double>> image(side, std::vector<double>(values.begin(), values.begin() + side));
+
+        report("plot", n, measure([&] () {
+            figure f;
+            f.axis().plot(values);
+            f.close();
+        }));
+        report("imshow", side*side, measure([&] () {
+            figure f;
+            f.axis().imshow(image);
+            f.close();
+        }));
+        report("imshow(callback)", side*side, measure([&] () {
+            figure f;
+            f.axis().imshow(grid{.rows = side, .cols = side}, [&] (const grid_location& loc) {
+                return image[loc.row][loc.col];
+            });
+            f.close();
+        }));
+        report("hist", n, measure([&] () {
+            figure f;
+            f.axis().hist(values, kwargs("bins"_kw = 100));
+            f.close();
+        }));
+        report("plot+save_to", n, measure([&] () {
+            figure f;
+            f.axis().plot(values);
+            f.save_to("memory_benchmark.png");
+            f.close();
+        }));
+    }
+    std::filesystem::remove("memory_benchmark.png");
+    return 0;
+}
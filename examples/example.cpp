@@ -54,6 +54,17 @@ int main() {
     image_and_plot.axis_at({0, 0}).imshow(image, no_kwargs, {.add_colorbar = true});
     image_and_plot.axis_at({0, 1}).plot(x_values, sine_values);
 
+    // Images may also be defined by a function that is evaluated (in parallel) on each location of a grid
+    figure function_image;
+    function_image.axis().imshow(grid{.rows = 100, .cols = 100}, [] (const grid_location& loc) {
+        return std::sin(0.1*static_cast<double>(loc.row))*std::cos(0.1*static_cast<double>(loc.col));
+    }, kwargs("cmap"_kw = "coolwarm"), {.add_colorbar = true});
+
+    // C++ invocables can be passed to python wherever a callable is expected, e.g. to format the ticks of an axis
+    py_invoke(function_image.axis().py_invoke("get_xaxis"), "set_major_formatter", args(callback([] (double x) {
+        return std::to_string(static_cast<int>(x)) + " px";
+    })));
+
     // If you need some feature that is not exposed via the libary, you can also let it invoke python functions
     image_and_plot.py_invoke("text", no_args, kwargs(
         "x"_kw = 0.5,
@@ -0,0 +1,222 @@
+// SPDX-FileCopyrightText: 2024 Dennis Gläser <dennis.a.glaeser@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Support for complex values: conversion of std::complex (and ranges thereof) into python objects, and lazy
+// projections of complex ranges onto real values (see `project`), e.g. for plotting or showing them as images.
+
+#pragma once
+
+#include <complex>
+
+#include "cpplot.hpp"
+
+namespace cpplot {
+
+#ifndef DOXYGEN
+namespace detail {
+
+    template<std::floating_point T> struct is_complex<std::complex<T>> : std::true_type {};
+
+}  // namespace detail
+#endif  // DOXYGEN
+
+//! Projections of complex values onto real values (see `project`)
+enum class complex_projection {
+    real,
+    imag,
+    magnitude,
+    decibels,  //!< 20*log10 of the magnitude (-inf for zero)
+    phase  //!< argument in radians
+};
+
+template<std::ranges::view V> class complex_projection_view;
+
+#ifndef DOXYGEN
+namespace detail {
+
+    //! Write the projections of the given complex values into the given output. The loops operate on the interleaved
+    //! real and imaginary parts in contiguous memory, such that compilers can vectorize them (where the math
+    //! functions permit, e.g. the magnitude with -fno-math-errno).
+    template<std::floating_point T>
+    void project(std::span<const std::complex<T>> values, complex_projection projection, std::span<T> out) {
+        const T* parts = reinterpret_cast<const T*>(values.data());
+        const std::size_t n = std::min(values.size(), out.size());
+        switch (projection) {
+            case complex_projection::real:
+                for (std::size_t i = 0; i < n; ++i) out[i] = parts[2*i];
+                break;
+            case complex_projection::imag:
+                for (std::size_t i = 0; i < n; ++i) out[i] = parts[2*i + 1];
+                break;
+            case complex_projection::magnitude:
+                for (std::size_t i = 0; i < n; ++i) out[i] = std::sqrt(parts[2*i]*parts[2*i] + parts[2*i + 1]*parts[2*i + 1]);
+                break;
+            case complex_projection::decibels:
+                for (std::size_t i = 0; i < n; ++i) out[i] = T{10}*std::log10(parts[2*i]*parts[2*i] + parts[2*i + 1]*parts[2*i + 1]);
+                break;
+            case complex_projection::phase:
+                for (std::size_t i = 0; i < n; ++i) out[i] = std::atan2(parts[2*i + 1], parts[2*i]);
+                break;
+        }
+    }
+
+    struct complex_projector {
+        complex_projection projection;
+
+        template<std::floating_point T>
+        T operator()(const std::complex<T>& value) const {
+            T result;
+            project(std::span{&value, 1}, projection, std::span{&result, 1});
+            return result;
+        }
+
+        template<std::ranges::viewable_range R>
+            requires(std::ranges::range<R>)
+        auto operator()(R&& row) const {
+            return complex_projection_view{std::views::all(std::forward<R>(row)), projection};
+        }
+    };
+
+    template<typename R>
+    concept complex_range = std::ranges::range<R> and is_complex<std::ranges::range_value_t<R>>::value;
+
+    template<typename R>
+    concept complex_range_2d = std::ranges::range<R> and complex_range<std::ranges::range_value_t<R>>;
+
+}  // namespace detail
+#endif  // DOXYGEN
+
+//! Lazy view on a 1d or 2d range of complex values, projected onto real values. When passed to python (e.g. to
+//! `axis::plot` or `axis::imshow`), the projections are written directly into a numpy array.
+template<std::ranges::view V>
+class complex_projection_view : public std::ranges::view_interface<complex_projection_view<V>> {
+    using base_iterator = std::ranges::iterator_t<const V>;
+    static constexpr bool is_forward = std::ranges::forward_range<const V>;
+
+ public:
+    //! Iterator over the projected values. Only the underlying range is stored in the view (such that views on
+    //! rvalue containers, which own the container and are move-only, are supported), and the iterators apply the
+    //! projection on dereferencing.
+    class iterator {
+     public:
+        using iterator_concept = std::conditional_t<is_forward, std::forward_iterator_tag, std::input_iterator_tag>;
+        using difference_type = std::ranges::range_difference_t<const V>;
+        using value_type = std::remove_cvref_t<
+            std::invoke_result_t<detail::complex_projector, std::ranges::range_reference_t<const V>>
+        >;
+
+        iterator() = default;
+        iterator(base_iterator it, complex_projection projection)
+        : _it{std::move(it)}
+        , _projection{projection}
+        {}
+
+        decltype(auto) operator*() const { return detail::complex_projector{_projection}(*_it); }
+        iterator& operator++() { ++_it; return *this; }
+        void operator++(int) requires(!is_forward) { ++_it; }
+        iterator operator++(int) requires(is_forward) { auto tmp = *this; ++_it; return tmp; }
+
+        friend bool operator==(const iterator& a, const iterator& b) requires(is_forward) { return a._it == b._it; }
+        friend bool operator==(const iterator& a, const std::ranges::sentinel_t<const V>& b) { return a._it == b; }
+
+     private:
+        base_iterator _it{};
+        complex_projection _projection{complex_projection::real};
+    };
+
+    complex_projection_view(V base, complex_projection projection)
+    : _base{std::move(base)}
+    , _projection{projection}
+    {}
+
+    iterator begin() const { return {std::ranges::begin(_base), _projection}; }
+    auto end() const {
+        if constexpr (std::ranges::common_range<const V>)
+            return iterator{std::ranges::end(_base), _projection};
+        else
+            return std::ranges::end(_base);
+    }
+    auto size() const requires(std::ranges::sized_range<const V>) { return std::ranges::size(_base); }
+
+    //! Return the underlying range of complex values
+    const V& base() const noexcept { return _base; }
+
+    //! Return the projection applied to the complex values
+    complex_projection projection() const noexcept { return _projection; }
+
+ private:
+    V _base;
+    complex_projection _projection;
+};
+
+template<std::ranges::viewable_range R>
+complex_projection_view(R&&, complex_projection) -> complex_projection_view<std::views::all_t<R>>;
+
+//! Return a view on the given range (of complex values, or of rows of complex values) projected onto real values
+template<std::ranges::viewable_range R>
+    requires(detail::complex_range<R> or detail::complex_range_2d<R>)
+auto project(R&& values, complex_projection projection) {
+    return complex_projection_view{std::views::all(std::forward<R>(values)), projection};
+}
+
+namespace traits {
+
+template<std::floating_point T>
+struct to_pyobject<std::complex<T>> {
+    static PyObject* from(const std::complex<T>& c) {
+        detail::pycontext{};
+        return detail::capi::from_complex(static_cast<double>(c.real()), static_cast<double>(c.imag()));
+    }
+};
+
+// complex values in contiguous memory are copied into a numpy array in one go
+template<std::ranges::contiguous_range R>
+    requires(detail::is_complex<std::ranges::range_value_t<R>>::value)
+struct to_pyobject<R> {
+    static PyObject* from(const R& range) {
+        using value_type = std::ranges::range_value_t<R>;
+        detail::pybuffer<value_type> buffer{std::ranges::size(range)};
+        std::ranges::copy(range, buffer.values().begin());
+        return buffer.array({std::ranges::size(range)}).release();
+    }
+};
+
+template<std::ranges::view V>
+struct to_pyobject<complex_projection_view<V>> {
+    static PyObject* from(const complex_projection_view<V>& view) {
+        const auto project_row = [&] <std::ranges::range R, typename T> (const R& row, std::span<T> out) {
+            if constexpr (std::ranges::contiguous_range<R>)
+                detail::project(std::span<const std::complex<T>>{std::ranges::data(row), std::ranges::size(row)}, view.projection(), out);
+            else
+                std::ranges::transform(row, out.begin(), detail::complex_projector{view.projection()});
+        };
+
+        if constexpr (detail::complex_range<V>) {
+            using T = typename std::ranges::range_value_t<V>::value_type;
+            const auto size = static_cast<std::size_t>(std::ranges::distance(view.base()));
+            detail::pybuffer<T> buffer{size};
+            project_row(view.base(), buffer.values());
+            return buffer.array({size}).release();
+        } else {
+            using T = typename std::ranges::range_value_t<std::ranges::range_value_t<V>>::value_type;
+            std::vector<decltype(std::views::all(std::declval<std::ranges::range_reference_t<const V>>()))> rows;
+            for (auto&& row : view.base())
+                rows.push_back(std::views::all(std::forward<decltype(row)>(row)));
+            const std::size_t cols = rows.empty() ? 0 : static_cast<std::size_t>(std::ranges::distance(rows[0]));
+            for (const auto& row : rows)
+                if (static_cast<std::size_t>(std::ranges::distance(row)) != cols)
+                    throw exceptions::size_error("All rows of a complex image must have the same size");
+
+            detail::pybuffer<T> buffer{rows.size()*cols};
+            const auto values = buffer.values();
+            detail::parallel_for(rows.size(), [&] (std::size_t i) {
+                project_row(rows[i], values.subspan(i*cols, cols));
+            });
+            return buffer.array({rows.size(), cols}).release();
+        }
+    }
+};
+
+}  // namespace traits
+
+}  // namespace cpplot
@@ -0,0 +1,684 @@
+// SPDX-FileCopyrightText: 2024 Dennis Gläser <dennis.a.glaeser@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Definitions of the non-template functions declared in cpplot.hpp. These are included into cpplot.hpp by default,
+// or compiled once into the cpplot_core library if CPPLOT_COMPILED_LIB is defined.
+
+#pragma once
+
+#ifdef CPPLOT_COMPILED_LIB
+    #include "cpplot.hpp"
+#endif
+#include "python.hpp"
+
+// headers only needed by the implementation, which compiled-lib users do not pay for
+#include <unordered_map>
+#include <thread>
+#include <numbers>
+#include <fstream>
+#include <filesystem>
+
+#ifdef __linux__
+    #include <unistd.h>
+#endif
+#ifdef __GLIBC__
+    #include <malloc.h>
+#endif
+
+namespace cpplot {
+
+#ifndef DOXYGEN
+namespace detail {
+
+    namespace capi {
+
+        CPPLOT_INLINE void print_error() { PyErr_Print(); }
+        CPPLOT_INLINE bool error_occurred() { return PyErr_Occurred() != nullptr; }
+
+        CPPLOT_INLINE PyObject* new_reference(PyObject* obj) { return Py_XNewRef(obj); }
+        CPPLOT_INLINE void release_reference(PyObject* obj) { Py_XDECREF(obj); }
+        CPPLOT_INLINE PyObject* none() { return Py_NewRef(Py_None); }
+        CPPLOT_INLINE bool is_none(PyObject* obj) { return obj == Py_None; }
+
+        CPPLOT_INLINE PyObject* from_bool(bool value) { return PyBool_FromLong(value); }
+        CPPLOT_INLINE PyObject* from_long(long value) { return PyLong_FromLong(value); }
+        CPPLOT_INLINE PyObject* from_size_t(std::size_t value) { return PyLong_FromSize_t(value); }
+        CPPLOT_INLINE PyObject* from_double(double value) { return PyFloat_FromDouble(value); }
+        CPPLOT_INLINE PyObject* from_complex(double real, double imag) { return PyComplex_FromDoubles(real, imag); }
+        CPPLOT_INLINE PyObject* from_string(const char* value) { return PyUnicode_FromString(value); }
+        CPPLOT_INLINE PyObject* from_wide_string(const wchar_t* value, std::size_t size) {
+            return PyUnicode_FromWideChar(value, static_cast<Py_ssize_t>(size));
+        }
+
+        CPPLOT_INLINE int is_true(PyObject* obj) { return PyObject_IsTrue(obj); }
+        CPPLOT_INLINE unsigned long long as_unsigned_long_long(PyObject* obj) {
+            // PyLong_AsUnsignedLongLong does not accept e.g. numpy integers
+            PyObject* index = PyNumber_Index(obj);
+            if (!index)
+                return static_cast<unsigned long long>(-1);
+            const unsigned long long value = PyLong_AsUnsignedLongLong(index);
+            Py_DECREF(index);
+            return value;
+        }
+        CPPLOT_INLINE long long as_long_long(PyObject* obj) { return PyLong_AsLongLong(obj); }
+        CPPLOT_INLINE double as_double(PyObject* obj) { return PyFloat_AsDouble(obj); }
+        CPPLOT_INLINE const char* as_utf8(PyObject* obj, std::size_t& size) {
+            Py_ssize_t length = 0;
+            const char* chars = PyUnicode_AsUTF8AndSize(obj, &length);
+            size = static_cast<std::size_t>(length);
+            return chars;
+        }
+
+        CPPLOT_INLINE PyObject* new_tuple(std::size_t size) { return PyTuple_New(static_cast<Py_ssize_t>(size)); }
+        CPPLOT_INLINE void tuple_set(PyObject* tuple, std::size_t i, PyObject* item) {
+            PyTuple_SetItem(tuple, static_cast<Py_ssize_t>(i), item);
+        }
+        CPPLOT_INLINE PyObject* new_list(std::size_t size) { return PyList_New(static_cast<Py_ssize_t>(size)); }
+        CPPLOT_INLINE void list_set(PyObject* list, std::size_t i, PyObject* item) {
+            PyList_SET_ITEM(list, static_cast<Py_ssize_t>(i), item);
+        }
+        CPPLOT_INLINE PyObject* new_dict() { return PyDict_New(); }
+        CPPLOT_INLINE bool dict_set(PyObject* dict, const char* key, PyObject* value) {
+            return value && PyDict_SetItemString(dict, key, value) == 0;
+        }
+
+        CPPLOT_INLINE bool is_sequence(PyObject* obj) { return PySequence_Check(obj) == 1; }
+        CPPLOT_INLINE std::ptrdiff_t sequence_size(PyObject* obj) { return PySequence_Size(obj); }
+        CPPLOT_INLINE PyObject* sequence_get(PyObject* obj, std::size_t i) {
+            return PySequence_GetItem(obj, static_cast<Py_ssize_t>(i));
+        }
+
+        CPPLOT_INLINE PyObject* new_bytearray(std::size_t size) {
+            return PyByteArray_FromStringAndSize(nullptr, static_cast<Py_ssize_t>(size));
+        }
+        CPPLOT_INLINE char* bytearray_data(PyObject* obj) { return PyByteArray_AS_STRING(obj); }
+
+        CPPLOT_INLINE PyObject* new_weak_reference(PyObject* obj) { return PyWeakref_NewRef(obj, nullptr); }
+        CPPLOT_INLINE PyObject* weak_reference_target(PyObject* ref) {
+#if PY_VERSION_HEX >= 0x030D0000
+            PyObject* target = nullptr;
+            PyWeakref_GetRef(ref, &target);  // yields a new reference, or null if the target is gone
+            return target;
+#else
+            PyObject* target = PyWeakref_GetObject(ref);  // borrowed, None if the target is gone
+            return target && target != Py_None ? Py_NewRef(target) : nullptr;
+#endif
+        }
+
+        CPPLOT_INLINE PyObject* import_module(const char* name) { return PyImport_ImportModule(name); }
+        CPPLOT_INLINE PyObject* get_attribute(PyObject* obj, const char* name) { return PyObject_GetAttrString(obj, name); }
+        CPPLOT_INLINE PyObject* call(PyObject* callable, PyObject* args, PyObject* kwargs) {
+            return PyObject_Call(callable, args, kwargs);
+        }
+
+        CPPLOT_INLINE bool disable_gc() { return PyGC_Disable() == 1; }
+        CPPLOT_INLINE void enable_gc() { PyGC_Enable(); }
+        CPPLOT_INLINE void collect_garbage() { PyGC_Collect(); }
+
+    }  // namespace capi
+
+    CPPLOT_INLINE python::python() {
+        _set_mpl_config_dir();
+        Py_Initialize();
+        if (!Py_IsInitialized())
+            throw exceptions::python_error("Could not initialize Python.");
+    }
+
+    CPPLOT_INLINE python::~python() {
+        if (Py_IsInitialized())
+            Py_Finalize();
+    }
+
+    CPPLOT_INLINE python& python::instance() {
+        static python py{};
+        return py;
+    }
+
+    CPPLOT_INLINE void set_environment_variable(const std::string& name, const std::string& value) {
+#ifdef _WIN32
+        _putenv_s(name.c_str(), value.c_str());
+#else
+        setenv(name.c_str(), value.c_str(), 1);
+#endif
+    }
+
+    CPPLOT_INLINE pyobject define_pyfunction(const std::string& name, const std::string& source) {
+        pycontext{};
+        auto globals = pyobject::from(PyDict_New());
+        PyDict_SetItemString(globals.get(), "__builtins__", PyEval_GetBuiltins());
+        pyobject::from(PyRun_String(source.c_str(), Py_file_input, globals.get(), globals.get()));
+        return pyobject::from(Py_XNewRef(PyDict_GetItemString(globals.get(), name.c_str())));
+    }
+
+    CPPLOT_INLINE double segment_distance(const polyline& line, std::size_t i, std::size_t a, std::size_t b, const std::array<double, 2>& scale) {
+        const double dx = (line.x[b] - line.x[a])*scale[0], dy = (line.y[b] - line.y[a])*scale[1];
+        const double px = (line.x[i] - line.x[a])*scale[0], py = (line.y[i] - line.y[a])*scale[1];
+        const double length_squared = dx*dx + dy*dy;
+        const double t = length_squared > 0.0 ? std::clamp((px*dx + py*dy)/length_squared, 0.0, 1.0) : 0.0;
+        return std::hypot(px - t*dx, py - t*dy);
+    }
+
+    CPPLOT_INLINE void mark_douglas_peucker(const polyline& line,
+                                            std::size_t first,
+                                            std::size_t last,
+                                            const std::array<double, 2>& scale,
+                                            double tolerance,
+                                            std::vector<bool>& keep) {
+        keep[first] = keep[last] = true;
+        std::vector<std::pair<std::size_t, std::size_t>> sections{{first, last}};
+        while (!sections.empty()) {
+            const auto [a, b] = sections.back();
+            sections.pop_back();
+
+            double max_distance = 0.0;
+            std::size_t farthest = a;
+            for (std::size_t i = a + 1; i < b; ++i)
+                if (const double distance = segment_distance(line, i, a, b, scale); distance > max_distance) {
+                    max_distance = distance;
+                    farthest = i;
+                }
+            if (max_distance > tolerance) {
+                keep[farthest] = true;
+                sections.push_back({a, farthest});
+                sections.push_back({farthest, b});
+            }
+        }
+    }
+
+    CPPLOT_INLINE polyline select(const polyline& line, const std::vector<bool>& keep) {
+        polyline result;
+        for (std::size_t i = 0; i < keep.size(); ++i)
+            if (keep[i]) {
+                result.x.push_back(line.x[i]);
+                result.y.push_back(line.y[i]);
+            }
+        return result;
+    }
+
+    CPPLOT_INLINE polyline clip_polyline(const polyline& line, std::array<double, 2> x_limits, std::array<double, 2> y_limits) {
+        std::ranges::sort(x_limits);
+        std::ranges::sort(y_limits);
+        const auto is_inside = [&] (std::size_t i) {
+            return line.x[i] >= x_limits[0] && line.x[i] <= x_limits[1]
+                && line.y[i] >= y_limits[0] && line.y[i] <= y_limits[1];
+        };
+        const auto is_visible = [&] (std::size_t i) {  // segment (i, i+1)
+            return std::max(line.x[i], line.x[i+1]) >= x_limits[0] && std::min(line.x[i], line.x[i+1]) <= x_limits[1]
+                && std::max(line.y[i], line.y[i+1]) >= y_limits[0] && std::min(line.y[i], line.y[i+1]) <= y_limits[1];
+        };
+
+        const std::size_t size = line.x.size();
+        polyline result;
+        std::size_t last_kept = size;
+        for (std::size_t i = 0; i < size; ++i) {
+            const bool keep = is_inside(i) || (i > 0 && is_visible(i - 1)) || (i + 1 < size && is_visible(i));
+            if (!keep)
+                continue;
+            if (last_kept != size && (last_kept + 1 != i || !is_visible(last_kept))) {
+                result.x.push_back(std::numeric_limits<double>::quiet_NaN());
+                result.y.push_back(std::numeric_limits<double>::quiet_NaN());
+            }
+            result.x.push_back(line.x[i]);
+            result.y.push_back(line.y[i]);
+            last_kept = i;
+        }
+        return result;
+    }
+
+    CPPLOT_INLINE polyline simplify_polyline(const polyline& line, const std::array<double, 2>& scale, double tolerance) {
+        const auto is_finite = [&] (std::size_t i) { return std::isfinite(line.x[i]) && std::isfinite(line.y[i]); };
+        std::vector<bool> keep(line.x.size(), false);
+        for (std::size_t first = 0; first < line.x.size();) {
+            if (!is_finite(first)) {
+                keep[first++] = true;
+                continue;
+            }
+            std::size_t last = first;
+            while (last + 1 < line.x.size() && is_finite(last + 1))
+                ++last;
+            mark_douglas_peucker(line, first, last, scale, tolerance, keep);
+            first = last + 1;
+        }
+        return select(line, keep);
+    }
+
+    CPPLOT_INLINE polyline simplify_polygon(const polyline& polygon, const std::array<double, 2>& scale, double tolerance) {
+        const std::size_t size = polygon.x.size();
+        if (size <= 3)
+            return polygon;
+
+        // split the ring at the corner farthest from the first one and close it temporarily
+        polyline ring = polygon;
+        ring.x.push_back(polygon.x.front());
+        ring.y.push_back(polygon.y.front());
+        std::size_t farthest = 0;
+        for (std::size_t i = 1; i < size; ++i)
+            if (segment_distance(ring, i, 0, 0, scale) > segment_distance(ring, farthest, 0, 0, scale))
+                farthest = i;
+        if (farthest == 0)
+            return polygon;
+
+        std::vector<bool> keep(size + 1, false);
+        mark_douglas_peucker(ring, 0, farthest, scale, tolerance, keep);
+        mark_douglas_peucker(ring, farthest, size, scale, tolerance, keep);
+        keep.pop_back();
+        if (std::ranges::count(keep, true) < 3) {
+            std::size_t third = 1;
+            for (std::size_t i = 1; i < size; ++i)
+                if (segment_distance(ring, i, 0, farthest, scale) > segment_distance(ring, third, 0, farthest, scale))
+                    third = i;
+            keep[third] = true;
+        }
+        return select(polygon, keep);
+    }
+
+    CPPLOT_INLINE std::vector<bool> select_non_overlapping(const std::vector<std::array<double, 4>>& boxes, double cell_size) {
+        std::vector<bool> selected(boxes.size(), false);
+        std::unordered_map<std::uint64_t, std::vector<std::size_t>> grid;
+        cell_size = std::max(cell_size, 1e-12);
+        const auto cell_index = [&] (double coordinate) {
+            return static_cast<std::int64_t>(std::floor(coordinate/cell_size));
+        };
+        // boxes are skipped unless their cell indices fit into the 32 bits per direction used in the keys
+        const auto is_indexable = [&] (double coordinate) {
+            return std::isfinite(coordinate) && std::abs(coordinate/cell_size) < 2147483647.0;
+        };
+        const auto key = [] (std::int64_t i, std::int64_t j) {
+            return (static_cast<std::uint64_t>(i) << 32) ^ static_cast<std::uint64_t>(j & 0xffffffff);
+        };
+        const auto for_each_cell = [&] (const std::array<double, 4>& box, auto&& action) {
+            for (auto i = cell_index(box[0]); i <= cell_index(box[2]); ++i)
+                for (auto j = cell_index(box[1]); j <= cell_index(box[3]); ++j)
+                    if (!action(key(i, j)))
+                        return false;
+            return true;
+        };
+        const auto overlap = [] (const std::array<double, 4>& a, const std::array<double, 4>& b) {
+            return a[0] < b[2] && b[0] < a[2] && a[1] < b[3] && b[1] < a[3];
+        };
+
+        for (std::size_t candidate = 0; candidate < boxes.size(); ++candidate) {
+            const auto& box = boxes[candidate];
+            if (!std::ranges::all_of(box, is_indexable))
+                continue;
+            const bool is_free = for_each_cell(box, [&] (std::uint64_t cell) {
+                const auto it = grid.find(cell);
+                return it == grid.end() || std::ranges::none_of(it->second, [&] (std::size_t other) {
+                    return overlap(box, boxes[other]);
+                });
+            });
+            if (is_free) {
+                selected[candidate] = true;
+                for_each_cell(box, [&] (std::uint64_t cell) { grid[cell].push_back(candidate); return true; });
+            }
+        }
+        return selected;
+    }
+
+    CPPLOT_INLINE void accumulate_segment(std::span<float> image, const grid& size, double x0, double y0, double x1, double y1) {
+        if (!std::isfinite(x0) || !std::isfinite(y0) || !std::isfinite(x1) || !std::isfinite(y1))
+            return;
+
+        // clip the segment to the pixels that can receive contributions, such that all coordinates are bounded by the
+        // image size before being converted to integers. Clipped endpoints are placed exactly onto the boundary and are
+        // interpolated from the other endpoint, which avoids cancellation for (huge) coordinates far outside the view.
+        const auto clip = [] (double& a0, double& b0, double& a1, double& b1, double lower, double upper) {
+            if ((a0 < lower && a1 < lower) || (a0 > upper && a1 > upper))
+                return false;
+            const auto move = [] (double& a, double& b, double a_other, double b_other, double bound) {
+                b = b_other + (bound - a_other)*((b - b_other)/(a - a_other));
+                a = bound;
+            };
+            if (a0 < lower) move(a0, b0, a1, b1, lower);
+            else if (a0 > upper) move(a0, b0, a1, b1, upper);
+            if (a1 < lower) move(a1, b1, a0, b0, lower);
+            else if (a1 > upper) move(a1, b1, a0, b0, upper);
+            return true;
+        };
+        if (!clip(x0, y0, x1, y1, -1.0, static_cast<double>(size.cols))
+            || !clip(y0, x0, y1, x1, -1.0, static_cast<double>(size.rows)))
+            return;
+        if (!std::isfinite(x0) || !std::isfinite(y0) || !std::isfinite(x1) || !std::isfinite(y1))
+            return;
+
+        const bool steep = std::abs(y1 - y0) > std::abs(x1 - x0);
+        if (steep) {
+            std::swap(x0, y0);
+            std::swap(x1, y1);
+        }
+        if (x0 > x1) {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+        }
+
+        const auto major_size = static_cast<std::int64_t>(steep ? size.rows : size.cols);
+        const auto minor_size = static_cast<std::int64_t>(steep ? size.cols : size.rows);
+        const double gradient = x1 > x0 ? (y1 - y0)/(x1 - x0) : 0.0;
+        const float weight = static_cast<float>(std::sqrt(1.0 + gradient*gradient));
+        const auto add = [&] (std::int64_t major, std::int64_t minor, float value) {
+            if (minor < 0 || minor >= minor_size)
+                return;
+            const auto [row, col] = steep ? std::pair{major, minor} : std::pair{minor, major};
+            image[static_cast<std::size_t>(row)*size.cols + static_cast<std::size_t>(col)] += value;
+        };
+
+        const auto clamp = [&] (double x) { return std::clamp(x, -1.0, static_cast<double>(major_size)); };
+        const auto first = std::max<std::int64_t>(static_cast<std::int64_t>(std::round(clamp(x0))), 0);
+        const auto last = std::min<std::int64_t>(static_cast<std::int64_t>(std::round(clamp(x1))), major_size - 1);
+        for (std::int64_t major = first; major <= last; ++major) {
+            const double minor = y0 + gradient*(static_cast<double>(major) - x0);
+            if (!(minor > -1.0 && minor < static_cast<double>(minor_size)))
+                continue;
+            const double lower = std::floor(minor);
+            const float fraction = static_cast<float>(minor - lower);
+            add(major, static_cast<std::int64_t>(lower), weight*(1.0f - fraction));
+            add(major, static_cast<std::int64_t>(lower) + 1, weight*fraction);
+        }
+    }
+
+    CPPLOT_INLINE void multi_select(std::span<double> values,
+                                    std::span<const std::size_t> ranks,
+                                    std::size_t offset,
+                                    unsigned parallel_levels) {
+        if (ranks.empty() || values.empty())
+            return;
+        const std::size_t mid = ranks.size()/2;
+        const std::size_t nth = ranks[mid] - offset;
+        std::nth_element(values.begin(), values.begin() + nth, values.end());
+        const auto select_left = [&] () {
+            multi_select(values.first(nth), ranks.first(mid), offset, parallel_levels > 0 ? parallel_levels - 1 : 0);
+        };
+        const auto select_right = [&] () {
+            multi_select(values.subspan(nth + 1), ranks.subspan(mid + 1), offset + nth + 1, parallel_levels > 0 ? parallel_levels - 1 : 0);
+        };
+        if (parallel_levels > 0)
+            parallel_for(2, [&] (std::size_t i) { i == 0 ? select_left() : select_right(); });
+        else {
+            select_left();
+            select_right();
+        }
+    }
+
+    CPPLOT_INLINE std::size_t hardware_threads() {
+        return std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    CPPLOT_INLINE void run_chunks(std::size_t num_chunks, const std::function<void(std::size_t)>& run_chunk) {
+        std::vector<std::thread> threads;
+        threads.reserve(num_chunks > 0 ? num_chunks - 1 : 0);
+        for (std::size_t chunk = 1; chunk < num_chunks; ++chunk)
+            threads.emplace_back(run_chunk, chunk);
+        if (num_chunks > 0)
+            run_chunk(0);
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    CPPLOT_INLINE pyobject numpy() {
+        pycontext{};
+        return pyobject::from(PyImport_ImportModule("numpy"));
+    }
+
+    CPPLOT_INLINE std::size_t resident_set_size() {
+#ifdef __linux__
+        std::size_t pages = 0, resident_pages = 0;
+        std::ifstream statm{"/proc/self/statm"};
+        if (statm >> pages >> resident_pages)
+            return resident_pages*static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+        return 0;
+    }
+
+    CPPLOT_INLINE std::size_t allocated_python_blocks() {
+        auto sys = pyobject::from(PyImport_ImportModule("sys"));
+        return from_pyobject<std::size_t>(pycall(sys, "getallocatedblocks"));
+    }
+
+    CPPLOT_INLINE void python::freeze() const {
+        auto gc = pyobject::from(PyImport_ImportModule("gc"));
+        pycall(gc, "freeze");
+    }
+
+    CPPLOT_INLINE memory_report python::trim_memory() const {
+        static const pyobject clear_caches = define_pyfunction("clear_caches", R"(
+def clear_caches():
+    import sys
+    caches = [
+        ("matplotlib.font_manager", "_get_font", "cache_clear"),
+        ("matplotlib.font_manager", "FontManager._findfont_cached", "cache_clear"),
+        ("matplotlib.text", "_get_text_metrics_with_cache_impl", "cache_clear"),
+        ("matplotlib.mathtext", "MathTextParser._parse_cached", "cache_clear"),
+        ("matplotlib.colors", "_colors_full_map.cache", "clear"),
+    ]
+    for module_name, path, clear in caches:
+        cache = sys.modules.get(module_name)  # skip modules that have not been loaded
+        try:
+            for attribute in path.split("."):
+                cache = getattr(cache, attribute)
+            getattr(cache, clear)()
+        except AttributeError:
+            pass
+    sys._clear_type_cache()
+)");
+
+        memory_report report{
+            .rss_before = resident_set_size(),
+            .rss_after = 0,
+            .python_blocks_before = allocated_python_blocks(),
+            .python_blocks_after = 0,
+            .collected_objects = 0
+        };
+        pycall(clear_caches, no_args);
+        report.collected_objects = static_cast<std::size_t>(PyGC_Collect());
+#ifdef __GLIBC__
+        malloc_trim(0);
+#endif
+        report.rss_after = resident_set_size();
+        report.python_blocks_after = allocated_python_blocks();
+        return report;
+    }
+
+    CPPLOT_INLINE pyobject get_attribute(const pyobject& obj, const std::string& name) {
+        return pyobject::from(PyObject_GetAttrString(obj.get(), name.c_str()));
+    }
+
+    CPPLOT_INLINE std::array<double, 2> get_limits(const pyobject& ax, const std::string& getter) {
+        auto limits = pycall(ax, getter);
+        return {
+            from_pyobject<double>(pyobject::from(PySequence_GetItem(limits.get(), 0))),
+            from_pyobject<double>(pyobject::from(PySequence_GetItem(limits.get(), 1)))
+        };
+    }
+
+    CPPLOT_INLINE std::array<double, 2> get_size_in_pixels(const pyobject& ax) {
+        auto extent = pycall(ax, "get_window_extent");
+        return {
+            from_pyobject<double>(get_attribute(extent, "width")),
+            from_pyobject<double>(get_attribute(extent, "height"))
+        };
+    }
+
+    CPPLOT_INLINE std::array<double, 2> get_fixed_limits(const pyobject& ax, const std::string& dir) {
+        if (from_pyobject<bool>(pycall(ax, "get_autoscale" + dir + "_on")))
+            return {-std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity()};
+        return get_limits(ax, "get_" + dir + "lim");
+    }
+
+    CPPLOT_INLINE pyobject make_pycallable(pyfunction f) {
+        static constexpr const char* capsule_name = "cpplot.pyfunction";
+        static PyMethodDef definition{
+            "cpplot_function",
+            [] (PyObject* self, PyObject* args) -> PyObject* {
+                const auto& function = *static_cast<pyfunction*>(PyCapsule_GetPointer(self, capsule_name));
+                try {
+                    auto result = function(pyobject{Py_XNewRef(args)});
+                    return result ? result.release() : Py_NewRef(Py_None);
+                } catch (const std::exception& e) {
+                    PyErr_SetString(PyExc_RuntimeError, e.what());
+                    return nullptr;
+                } catch (...) {
+                    // exceptions must not propagate through the python interpreter
+                    PyErr_SetString(PyExc_RuntimeError, "unknown C++ exception");
+                    return nullptr;
+                }
+            },
+            METH_VARARGS,
+            nullptr
+        };
+
+        pycontext{};
+        auto function = std::make_unique<pyfunction>(std::move(f));
+        auto capsule = pyobject::from(PyCapsule_New(function.get(), capsule_name, [] (PyObject* c) {
+            delete static_cast<pyfunction*>(PyCapsule_GetPointer(c, capsule_name));
+        }));
+        function.release();
+        return pyobject::from(PyCFunction_New(&definition, capsule.get()));
+    }
+
+    // The bound artists reference the buffers through matplotlib's internal state, where the public setters would
+    // copy the data. If that state is not as expected (e.g. in other matplotlib versions), refresh falls back to the
+    // public setters.
+    inline const std::string persistent_buffer_functions = R"(
+import numpy as np
+
+def bind_line_buffers(line, x, y):
+    try:
+        line._xorig, line._yorig = x, y
+        line.recache(always=True)
+        line._subslice = False  # the x-values may become unsorted in later frames
+        xy = line._xy
+        line._cpplot_buffers = ("line", x, y, xy, xy[:, 0], xy[:, 1])
+    except AttributeError:
+        line._cpplot_buffers = ("line", x, y, None, None, None)
+
+def bind_image_buffer(image, values):
+    masked = None
+    if hasattr(image, "_A"):
+        masked = np.ma.MaskedArray(values, mask=np.isnan(values), copy=False)
+        image._A = masked
+    image._cpplot_buffers = ("image", values, masked)
+
+def refresh(artist):
+    buffers = getattr(artist, "_cpplot_buffers", None)
+    if buffers is not None and buffers[0] == "line":
+        _, x, y, xy, x_view, y_view = buffers
+        if xy is None or getattr(artist, "_xy", None) is not xy or artist._invalidx or artist._invalidy:
+            artist.set_data(x, y)
+            bind_line_buffers(artist, x, y)
+        else:
+            np.copyto(x_view, x)
+            np.copyto(y_view, y)
+            if artist._path is None or artist._path.vertices is not xy:  # e.g. for step drawstyles
+                artist._invalidx = True
+            artist._transformed_path = None
+    elif buffers is not None:
+        _, values, masked = buffers
+        if masked is None or getattr(artist, "_A", None) is not masked:
+            artist.set_data(values)
+            bind_image_buffer(artist, values)
+        else:
+            np.isnan(values, out=masked._mask)
+            artist._imcache = None
+    artist.stale = True
+)";
+
+    CPPLOT_INLINE void bind_line_buffers(const pyobject& line, const pyobject& x, const pyobject& y) {
+        static const pyobject bind = define_pyfunction("bind_line_buffers", persistent_buffer_functions);
+        pycall(bind, args(line, x, y));
+    }
+
+    CPPLOT_INLINE void bind_image_buffer(const pyobject& image, const pyobject& values) {
+        static const pyobject bind = define_pyfunction("bind_image_buffer", persistent_buffer_functions);
+        pycall(bind, args(image, values));
+    }
+
+    CPPLOT_INLINE std::array<double, 2> pixels_per_unit(const pyobject& ax, const polyline& line) {
+        const bool has_data = from_pyobject<bool>(pycall(ax, "has_data"));
+        const auto pixels = get_size_in_pixels(ax);
+        const auto scale = [&] (const std::vector<double>& values, const std::string& dir, double pixels) {
+            auto limits = get_limits(ax, "get_" + dir + "lim");
+            if (from_pyobject<bool>(pycall(ax, "get_autoscale" + dir + "_on"))) {
+                if (!has_data)
+                    limits = {std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest()};
+                for (double v : values)
+                    if (std::isfinite(v)) { limits[0] = std::min(limits[0], v); limits[1] = std::max(limits[1], v); }
+            }
+            const double range = std::abs(limits[1] - limits[0]);
+            return range > 0.0 && std::isfinite(range) ? pixels/range : 0.0;
+        };
+        return {scale(line.x, "x", pixels[0]), scale(line.y, "y", pixels[1])};
+    }
+
+    CPPLOT_INLINE std::vector<double> window_coefficients(window_function window, std::size_t size) {
+        std::vector<double> coefficients(size, 1.0);
+        const double denominator = size > 1 ? static_cast<double>(size - 1) : 1.0;
+        for (std::size_t i = 0; i < size; ++i) {
+            const double phase = 2.0*std::numbers::pi*static_cast<double>(i)/denominator;
+            switch (window) {
+                case window_function::rectangular: break;
+                case window_function::hann: coefficients[i] = 0.5 - 0.5*std::cos(phase); break;
+                case window_function::hamming: coefficients[i] = 0.54 - 0.46*std::cos(phase); break;
+                case window_function::blackman: coefficients[i] = 0.42 - 0.5*std::cos(phase) + 0.08*std::cos(2.0*phase); break;
+            }
+        }
+        return coefficients;
+    }
+
+}  // namespace detail
+#endif  // DOXYGEN
+
+CPPLOT_INLINE pyobject pyplot() {
+    return detail::plt{}.pyplot;
+}
+
+CPPLOT_INLINE void show() {
+    detail::plt plt{};
+    detail::pycall(plt.pyplot, "show");
+}
+
+CPPLOT_INLINE void refresh(const pyobject& artist) {
+    static const pyobject refresh_artist = detail::define_pyfunction("refresh", detail::persistent_buffer_functions);
+    detail::pycall(refresh_artist, args(artist));
+}
+
+CPPLOT_INLINE void set_memory_policy(const memory_policy& policy) {
+    detail::python::instance().set_memory_policy(policy);
+}
+
+CPPLOT_INLINE memory_policy get_memory_policy() {
+    return detail::python::instance().get_memory_policy();
+}
+
+CPPLOT_INLINE memory_report trim_memory() {
+    return detail::python::instance().trim_memory();
+}
+
+CPPLOT_INLINE void freeze_gc() {
+    detail::python::instance().freeze();
+}
+
+CPPLOT_INLINE detail::python::gc_pause pause_gc() {
+    return detail::python::instance().pause_gc();
+}
+
+CPPLOT_INLINE cache_info warm_up_cache() {
+    detail::pycontext{};
+    auto mpl = pyobject::from(PyImport_ImportModule("matplotlib"));
+    auto font_manager = pyobject::from(PyImport_ImportModule("matplotlib.font_manager"));  // builds the font cache
+    cache_info info{
+        .config_dir = detail::from_pyobject<std::string>(detail::pycall(mpl, "get_configdir")),
+        .cache_dir = detail::from_pyobject<std::string>(detail::pycall(mpl, "get_cachedir")),
+        .backend = detail::from_pyobject<std::string>(detail::pycall(mpl, "get_backend"))  // probes available GUI toolkits
+    };
+
+    const auto rc_file = std::filesystem::path{info.config_dir} / "matplotlibrc";
+    if (!std::filesystem::exists(rc_file)) {
+        std::ofstream rc{rc_file};
+        rc << "backend: " << info.backend << "\n";
+        if (!rc)
+            throw exceptions::exception("Could not write " + rc_file.string());
+    }
+    return info;
+}
+
+}  // namespace cpplot
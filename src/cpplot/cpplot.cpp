@@ -0,0 +1,11 @@
+// SPDX-FileCopyrightText: 2024 Dennis Gläser <dennis.a.glaeser@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Translation unit of the cpplot_core library, which holds the non-template functions of cpplot
+// (enable with -DCPPLOT_BUILD_COMPILED_LIB=ON and link against cpplot::cpplot_core).
+
+#ifndef CPPLOT_COMPILED_LIB
+    #error "cpplot.cpp must be compiled with CPPLOT_COMPILED_LIB defined"
+#endif
+
+#include "cpplot-inl.hpp"
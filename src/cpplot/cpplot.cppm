@@ -0,0 +1,122 @@
+// SPDX-FileCopyrightText: 2024 Dennis Gläser <dennis.a.glaeser@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Module interface unit exporting the public API of cpplot (enable with -DCPPLOT_BUILD_MODULE=ON and link against
+// cpplot::module). The header is included in the global module fragment, such that neither the macros of Python.h
+// nor those of cpplot are visible to importers. Code that implements traits::to_pyobject has to include
+// cpplot/python.hpp.
+// The module includes all optional feature headers, since importers only pay for what they use.
+
+module;
+
+#include <cpplot/cpplot.hpp>
+#include <cpplot/complex.hpp>
+#include <cpplot/line_density.hpp>
+#include <cpplot/lod.hpp>
+#include <cpplot/mosaic.hpp>
+#include <cpplot/spectrogram.hpp>
+#include <cpplot/statistics.hpp>
+#include <cpplot/triple_buffer.hpp>
+
+export module cpplot;
+
+export namespace cpplot {
+
+namespace exceptions {
+    using cpplot::exceptions::exception;
+    using cpplot::exceptions::python_error;
+    using cpplot::exceptions::size_error;
+}  // namespace exceptions
+
+namespace traits {
+    using cpplot::traits::image_size;
+    using cpplot::traits::image_access;
+    using cpplot::traits::point_access;
+    using cpplot::traits::to_pyobject;
+}  // namespace traits
+
+namespace concepts {
+    using cpplot::concepts::scalar;
+    using cpplot::concepts::range_1d;
+    using cpplot::concepts::range_2d;
+    using cpplot::concepts::point_2d;
+    using cpplot::concepts::as_image;
+    using cpplot::concepts::image;
+    using cpplot::concepts::to_pyobject;
+    using cpplot::concepts::kwarg;
+}  // namespace concepts
+
+namespace literals {
+    using cpplot::literals::operator""_kw;
+}  // namespace literals
+
+using cpplot::grid;
+using cpplot::grid_location;
+
+using cpplot::pyobject;
+using cpplot::none;
+using cpplot::kwarg;
+using cpplot::py_args;
+using cpplot::py_kwargs;
+using cpplot::no_args;
+using cpplot::no_kwargs;
+using cpplot::args;
+using cpplot::kwargs;
+using cpplot::kw;
+using cpplot::py_callback;
+using cpplot::callback;
+using cpplot::py_invoke;
+using cpplot::persistent_buffer;
+using cpplot::triple_buffer;
+using cpplot::pyerror_observer_type;
+using cpplot::pyerror_observer;
+
+using cpplot::memory_policy;
+using cpplot::memory_report;
+using cpplot::set_memory_policy;
+using cpplot::get_memory_policy;
+using cpplot::trim_memory;
+using cpplot::freeze_gc;
+using cpplot::pause_gc;
+using cpplot::cache_info;
+using cpplot::warm_up_cache;
+using cpplot::profile_entry;
+using cpplot::artist_profile_entry;
+using cpplot::profile_report;
+using cpplot::profile_options;
+using cpplot::profile;
+
+using cpplot::imshow_options;
+using cpplot::bar_options;
+using cpplot::plot_options;
+using cpplot::fill_options;
+using cpplot::annotate_options;
+using cpplot::plot_function_options;
+using cpplot::ecdf_options;
+using cpplot::quantile_band_options;
+using cpplot::line_density_options;
+using cpplot::mosaic_options;
+using cpplot::progressive_save;
+using cpplot::progressive_save_options;
+using cpplot::window_function;
+using cpplot::spectrogram_options;
+using cpplot::lod_series;
+using cpplot::quantile_sketch;
+using cpplot::streaming_quantiles;
+using cpplot::running_moments;
+using cpplot::bucket_series;
+using cpplot::streaming_moments;
+using cpplot::mean_band_options;
+using cpplot::complex_projection;
+using cpplot::complex_projection_view;
+using cpplot::project;
+
+using cpplot::style;
+using cpplot::default_style;
+using cpplot::axis;
+using cpplot::figure;
+using cpplot::pdf_report;
+using cpplot::pyplot;
+using cpplot::show;
+
+}  // namespace cpplot
@@ -1,30 +1,40 @@
 // SPDX-FileCopyrightText: 2024 Dennis Gläser <dennis.a.glaeser@gmail.com>
 // SPDX-License-Identifier: MIT
 
+#pragma once
+
 #include <exception>
 #include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
 #include <source_location>
 #include <type_traits>
 #include <functional>
 #include <utility>
+#include <memory>
+#include <optional>
 #include <algorithm>
 #include <concepts>
+#include <limits>
+#include <cmath>
 #include <ranges>
 
 #include <string_view>
+#include <string>
 #include <vector>
+#include <array>
+#include <span>
+
 
+// Python.h is only included by the implementation (see cpplot/python.hpp)
+struct _object;
+typedef _object PyObject;
 
-#ifdef CPPLOT_DISABLE_PYTHON_DEBUG_BUILD
-    #ifdef _DEBUG
-        #undef _DEBUG
-        #include <Python.h>
-        #define _DEBUG
-    #else
-        #include <Python.h>
-    #endif
+// With CPPLOT_COMPILED_LIB, the non-template functions are compiled into the cpplot_core library (see cpplot.cpp)
+#ifdef CPPLOT_COMPILED_LIB
+    #define CPPLOT_INLINE
 #else
-    #include <Python.h>
+    #define CPPLOT_INLINE inline
 #endif
 
 
@@ -87,6 +97,67 @@ namespace detail {
     template<typename T>
     inline constexpr bool is_complete = !decltype(is_incomplete(std::declval<T*>()))::value;
 
+    template<typename T> struct is_optional : std::false_type {};
+    template<typename T> struct is_optional<std::optional<T>> : std::true_type {};
+    template<typename T> struct is_vector : std::false_type {};
+    template<typename T> struct is_vector<std::vector<T>> : std::true_type {};
+    template<typename T> struct is_tuple : std::false_type {};
+    template<typename... T> struct is_tuple<std::tuple<T...>> : std::true_type {};
+    template<typename T> struct is_complex : std::false_type {};
+
+    //! Thin wrappers around the python C API used by the templates in this header, which thus do not depend on
+    //! Python.h. Functions returning PyObject* return new references (nullptr on errors), and *_set steal the item.
+    namespace capi {
+
+        CPPLOT_INLINE void print_error();
+        CPPLOT_INLINE bool error_occurred();
+
+        CPPLOT_INLINE PyObject* new_reference(PyObject* obj);  // nullptr-safe
+        CPPLOT_INLINE void release_reference(PyObject* obj);  // nullptr-safe
+        CPPLOT_INLINE PyObject* none();
+        CPPLOT_INLINE bool is_none(PyObject* obj);
+
+        CPPLOT_INLINE PyObject* from_bool(bool value);
+        CPPLOT_INLINE PyObject* from_long(long value);
+        CPPLOT_INLINE PyObject* from_size_t(std::size_t value);
+        CPPLOT_INLINE PyObject* from_double(double value);
+        CPPLOT_INLINE PyObject* from_complex(double real, double imag);
+        CPPLOT_INLINE PyObject* from_string(const char* value);
+        CPPLOT_INLINE PyObject* from_wide_string(const wchar_t* value, std::size_t size);
+
+        CPPLOT_INLINE int is_true(PyObject* obj);
+        CPPLOT_INLINE unsigned long long as_unsigned_long_long(PyObject* obj);  // also accepts e.g. numpy integers
+        CPPLOT_INLINE long long as_long_long(PyObject* obj);
+        CPPLOT_INLINE double as_double(PyObject* obj);
+        CPPLOT_INLINE const char* as_utf8(PyObject* obj, std::size_t& size);
+
+        CPPLOT_INLINE PyObject* new_tuple(std::size_t size);
+        CPPLOT_INLINE void tuple_set(PyObject* tuple, std::size_t i, PyObject* item);
+        CPPLOT_INLINE PyObject* new_list(std::size_t size);
+        CPPLOT_INLINE void list_set(PyObject* list, std::size_t i, PyObject* item);
+        CPPLOT_INLINE PyObject* new_dict();
+        CPPLOT_INLINE bool dict_set(PyObject* dict, const char* key, PyObject* value);  // does not steal the value
+
+        CPPLOT_INLINE bool is_sequence(PyObject* obj);
+        CPPLOT_INLINE std::ptrdiff_t sequence_size(PyObject* obj);  // -1 on errors
+        CPPLOT_INLINE PyObject* sequence_get(PyObject* obj, std::size_t i);
+
+        CPPLOT_INLINE PyObject* new_bytearray(std::size_t size);
+        CPPLOT_INLINE char* bytearray_data(PyObject* obj);
+
+        CPPLOT_INLINE PyObject* new_weak_reference(PyObject* obj);
+        CPPLOT_INLINE PyObject* weak_reference_target(PyObject* ref);  // nullptr if the target has been destroyed
+
+        CPPLOT_INLINE PyObject* import_module(const char* name);
+        CPPLOT_INLINE PyObject* get_attribute(PyObject* obj, const char* name);
+        CPPLOT_INLINE PyObject* call(PyObject* callable, PyObject* args, PyObject* kwargs);
+
+        CPPLOT_INLINE bool disable_gc();  // returns whether it was enabled
+        CPPLOT_INLINE void enable_gc();
+        CPPLOT_INLINE void collect_garbage();
+
+    }  // namespace capi
+
 }  // namespace detail
 #endif  // DOXYGEN
 
@@ -149,8 +220,9 @@ inline constexpr py_args<> no_args{};
 inline constexpr py_kwargs<> no_kwargs{};
 
 
-//! Global error observer to customize behaviour when python errors are raised
-static struct {
+//! Observer that is notified by the library when python errors are raised
+class pyerror_observer_type {
+ public:
     using observer = std::function<void()>;
 
     //! Called by the library when an error occurs
@@ -167,31 +239,96 @@ static struct {
 
  private:
     observer _observer = [] () {
-        PyErr_Print();
+        detail::capi::print_error();
         throw exceptions::python_error("Python error occurred");
     };
-} pyerror_observer;
+};
+
+//! Global error observer to customize behaviour when python errors are raised
+inline pyerror_observer_type pyerror_observer;
 
 
+//! Policy for managing python-side memory in long-running processes (see `set_memory_policy`)
+struct memory_policy {
+    bool collect_after_close = false;  //!< run the garbage collector whenever a figure is closed
+    std::size_t trim_interval = 0;  //!< call `trim_memory` after every n closed figures (0 = never)
+};
+
+//! Memory usage before and after a call to `trim_memory`
+struct memory_report {
+    std::size_t rss_before;  //!< resident set size of the process in bytes (0 if not available on this platform)
+    std::size_t rss_after;
+    std::size_t python_blocks_before;  //!< number of memory blocks currently allocated by python
+    std::size_t python_blocks_after;
+    std::size_t collected_objects;  //!< number of unreachable objects found by the garbage collector
+};
+
 #ifndef DOXYGEN
 namespace detail {
+    //! Set an environment variable of this process (overwrites existing values)
+    CPPLOT_INLINE void set_environment_variable(const std::string& name, const std::string& value);
+
     class python {
-        explicit python() {
-            Py_Initialize();
-            if (!Py_IsInitialized())
-                throw exceptions::python_error("Could not initialize Python.");
-        };
+        CPPLOT_INLINE explicit python();
 
      public:
         python(const python&) = delete;
-        ~python() {
-            if (Py_IsInitialized())
-                Py_Finalize();
+        CPPLOT_INLINE ~python();
+
+        CPPLOT_INLINE static python& instance();
+
+        //! Disables python's cyclic garbage collector during its lifetime (e.g. while building many figures)
+        class gc_pause {
+         public:
+            gc_pause() : _was_enabled{capi::disable_gc()} {}
+            gc_pause(const gc_pause&) = delete;
+            ~gc_pause() { if (_was_enabled) capi::enable_gc(); }
+
+         private:
+            bool _was_enabled;
+        };
+
+        //! Set the policy for managing memory, which is applied whenever a figure is closed
+        void set_memory_policy(const memory_policy& policy) {
+            _memory_policy = policy;
+        }
+
+        //! Return the current memory policy
+        const memory_policy& get_memory_policy() const {
+            return _memory_policy;
         }
 
-        static const python& instance() {
-            static python py{};
-            return py;
+        //! Disable the garbage collector until the returned object goes out of scope
+        [[nodiscard]] gc_pause pause_gc() const {
+            return {};
+        }
+
+        //! Move all objects currently tracked by the garbage collector into a permanent generation that is ignored
+        //! in future collections (useful after setting up long-lived objects, see python's gc.freeze)
+        void freeze() const;
+
+        //! Collect garbage, clear matplotlib's internal caches and return freed memory to the system where possible
+        memory_report trim_memory() const;
+
+        //! Apply the memory policy after a figure has been closed
+        void notify_figure_closed() {
+            ++_closed_figures;
+            if (_memory_policy.trim_interval > 0 && _closed_figures % _memory_policy.trim_interval == 0)
+                trim_memory();
+            else if (_memory_policy.collect_after_close)
+                capi::collect_garbage();
+        }
+
+     private:
+        memory_policy _memory_policy;
+        std::size_t _closed_figures = 0;
+
+        //! Point matplotlib to the config/cache directory prepared at build time (see `warm_up_cache`)
+        static void _set_mpl_config_dir() {
+#ifdef CPPLOT_MPLCONFIGDIR
+            if (!std::getenv("MPLCONFIGDIR"))
+                set_environment_variable("MPLCONFIGDIR", CPPLOT_MPLCONFIGDIR);
+#endif
         }
     };
 
@@ -205,17 +342,16 @@ namespace detail {
 //! Wrapper around a PyObject*, i.e. the python object representation
 class pyobject {
  public:
-    ~pyobject() { if (_obj) Py_XDECREF(_obj); }
+    ~pyobject() { if (_obj) detail::capi::release_reference(_obj); }
 
     explicit pyobject(PyObject* obj) : _obj{obj} {}
-    pyobject(const pyobject& other) : pyobject{Py_XNewRef(other._obj)} {}
+    pyobject(const pyobject& other) : pyobject{detail::capi::new_reference(other._obj)} {}
     pyobject(pyobject&& other) : pyobject{other.release()} {}
     pyobject() = default;
 
     pyobject& operator=(const pyobject& other) {
-        pyobject{release()};
-        _obj = other._obj;
-        Py_XINCREF(_obj);
+        // acquire the new reference before releasing ours, in case of self-assignment
+        pyobject{std::exchange(_obj, detail::capi::new_reference(other._obj))};
         return *this;
     }
 
@@ -232,7 +368,7 @@ class pyobject {
 
     static pyobject none() {
         detail::pycontext{};
-        return pyobject{Py_None};
+        return pyobject{detail::capi::none()};
     }
 
     PyObject* get() const noexcept { return _obj; }
@@ -255,13 +391,13 @@ namespace detail {
     template<typename T>
     pyobject to_pyobject(const T& t) {
         return pyobject::from(overloads{
-            [] (bool b) { return b ? Py_True : Py_False; },
-            [] (std::integral auto i) { return PyLong_FromLong(static_cast<long>(i)); },
-            [] (std::unsigned_integral auto i) { return PyLong_FromSize_t(static_cast<std::size_t>(i)); },
-            [] (std::floating_point auto f) { return PyFloat_FromDouble(static_cast<double>(f)); },
-            [] (const char* s) { return PyUnicode_FromString(s); },
-            [] (const std::string& s) { return PyUnicode_FromString(s.c_str()); },
-            [] (const std::wstring& s) { return PyUnicode_FromWideChar(s.data(), s.size()); },
+            [] (bool b) { return capi::from_bool(b); },
+            [] (std::integral auto i) { return capi::from_long(static_cast<long>(i)); },
+            [] (std::unsigned_integral auto i) { return capi::from_size_t(static_cast<std::size_t>(i)); },
+            [] (std::floating_point auto f) { return capi::from_double(static_cast<double>(f)); },
+            [] (const char* s) { return capi::from_string(s); },
+            [] (const std::string& s) { return capi::from_string(s.c_str()); },
+            [] (const std::wstring& s) { return capi::from_wide_string(s.data(), s.size()); },
             [] (const pyobject& p) { return pyobject{p}.release(); },
             [] <concepts::to_pyobject O> (const O& o) { return traits::to_pyobject<O>::from(o); }
         }(t));
@@ -270,23 +406,14 @@ namespace detail {
     template<typename... T>
     pyobject to_pytuple(T&&... t) {
         pycontext{};
-        auto tuple = pyobject::from(PyTuple_New(sizeof...(T)));
+        auto tuple = pyobject::from(capi::new_tuple(sizeof...(T)));
         const auto push = [&] <std::size_t... is> (std::index_sequence<is...>) {
-            (..., PyTuple_SetItem(tuple.get(), is, to_pyobject(t).release()));
+            (..., capi::tuple_set(tuple.get(), is, to_pyobject(t).release()));
         };
         push(std::index_sequence_for<T...>{});
         return tuple;
     }
 
-    template<typename F, typename... O, concepts::kwarg K, concepts::kwarg... Ks>
-    constexpr decltype(auto) invoke_interleaved(F&& f, std::tuple<O...>&& interleaved, const K& kwarg, Ks&&... kwargs) {
-        auto extended = std::tuple_cat(std::move(interleaved), std::tuple{kwarg.name.c_str(), to_pyobject(kwarg.value).release()});
-        if constexpr (sizeof...(Ks) == 0)
-            return std::apply(f, std::move(extended));
-        else
-            return invoke_interleaved(std::forward<F>(f), std::move(extended), std::forward<Ks>(kwargs)...);
-    }
-
     template<concepts::kwarg... K> requires(sizeof...(K) == 0)
     pyobject to_pydict(K&&... kwargs) {
         return pyobject{nullptr};
@@ -294,39 +421,262 @@ namespace detail {
 
     template<concepts::kwarg... K> requires(sizeof...(K) > 0)
     pyobject to_pydict(K&&... kwargs) {
-        std::string format = "{";
-        for ([[maybe_unused]] std::size_t i = 0; i < sizeof...(K); ++i)
-            format += "s:O,";
-        format.back() = '}';
-
         pycontext{};
-        auto dict = invoke_interleaved([&] (const auto&... interleaved) {
-            return pyobject::from(Py_BuildValue(format.c_str(), interleaved...));
-        }, std::tuple{}, kwargs...);
-
-        if (!dict)
+        auto dict = pyobject::from(capi::new_dict());
+        const bool success = dict && (... && capi::dict_set(dict.get(), kwargs.name.c_str(), to_pyobject(kwargs.value).get()));
+        if (!success)
             throw exceptions::python_error("Conversion to python dictionary failed.");
         return dict;
     }
 
     template<typename... A, concepts::kwarg... K>
-    pyobject pycall(const pyobject& obj,
-                    const std::string& function,
-                    const py_args<A...>& args = py_args<>{},
+    pyobject pycall(const pyobject& callable,
+                    const py_args<A...>& args,
                     const py_kwargs<K...>& kwargs = py_kwargs<>{}) {
-        auto f = pyobject::from(PyObject_GetAttrString(obj.get(), function.c_str()));
         auto pyargs = std::apply([&] (const auto&... arg) { return to_pytuple(arg...); }, args.values);
         auto pykwargs = std::apply([&] (const auto&... kwarg) { return to_pydict(kwarg...); }, kwargs.values);
-        if (!f || !pyargs)
+        if (!callable || !pyargs)
            return pyobject{nullptr};
-        return pyobject::from(PyObject_Call(f.get(), pyargs.get(), pykwargs.get()));
+        return pyobject::from(capi::call(callable.get(), pyargs.get(), pykwargs.get()));
+    }
+
+    template<typename... A, concepts::kwarg... K>
+    pyobject pycall(const pyobject& obj,
+                    const std::string& function,
+                    const py_args<A...>& args = py_args<>{},
+                    const py_kwargs<K...>& kwargs = py_kwargs<>{}) {
+        auto f = pyobject::from(capi::get_attribute(obj.get(), function.c_str()));
+        return pycall(f, args, kwargs);
+    }
+
+    //! Combine two sets of keyword arguments (for duplicate names, the latter take precedence in python)
+    template<typename... A, typename... B>
+    auto merge(const py_kwargs<A...>& a, const py_kwargs<B...>& b) {
+        return std::apply([&] (const auto&... kwargs_a) {
+            return std::apply([&] (const auto&... kwargs_b) {
+                return py_kwargs{std::forward_as_tuple(kwargs_a..., kwargs_b...)};
+            }, b.values);
+        }, a.values);
+    }
+
+    //! Define a python function from the given source code and return it
+    CPPLOT_INLINE pyobject define_pyfunction(const std::string& name, const std::string& source);
+
+    template<typename T>
+    T from_pyobject(const pyobject& obj) {
+        const auto check = [] <typename V> (V&& value) -> V {
+            if (capi::error_occurred())
+                pyerror_observer.notify();
+            return std::forward<V>(value);
+        };
+
+        if constexpr (std::is_same_v<T, pyobject>)
+            return obj;
+        else if constexpr (is_optional<T>::value)
+            return capi::is_none(obj.get()) ? T{} : T{from_pyobject<typename T::value_type>(obj)};
+        else if constexpr (is_vector<T>::value) {
+            const std::ptrdiff_t size = check(capi::sequence_size(obj.get()));
+            T result;
+            result.reserve(static_cast<std::size_t>(std::max(size, std::ptrdiff_t{0})));
+            for (std::ptrdiff_t i = 0; i < size; ++i)
+                result.push_back(from_pyobject<typename T::value_type>(
+                    pyobject::from(capi::sequence_get(obj.get(), static_cast<std::size_t>(i)))
+                ));
+            return result;
+        }
+        else if constexpr (is_tuple<T>::value) {
+            if (check(capi::sequence_size(obj.get())) != static_cast<std::ptrdiff_t>(std::tuple_size_v<T>))
+                throw exceptions::size_error("Python sequence size does not match the tuple size");
+            return [&] <std::size_t... i> (std::index_sequence<i...>) {
+                return T{from_pyobject<std::tuple_element_t<i, T>>(pyobject::from(capi::sequence_get(obj.get(), i)))...};
+            }(std::make_index_sequence<std::tuple_size_v<T>>{});
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+            return check(capi::is_true(obj.get()) == 1);
+        else if constexpr (std::unsigned_integral<T>)
+            return check(static_cast<T>(capi::as_unsigned_long_long(obj.get())));
+        else if constexpr (std::integral<T>)
+            return check(static_cast<T>(capi::as_long_long(obj.get())));
+        else if constexpr (std::floating_point<T>)
+            return check(static_cast<T>(capi::as_double(obj.get())));
+        else if constexpr (std::is_same_v<T, std::string>) {
+            std::size_t size = 0;
+            const char* chars = check(capi::as_utf8(obj.get(), size));
+            return chars ? std::string(chars, size) : std::string{};
+        }
+        else
+            static_assert(!std::is_same_v<T, T>, "Unsupported conversion from python object");
+    }
+
+    //! Return the number of hardware threads (at least one)
+    CPPLOT_INLINE std::size_t hardware_threads();
+
+    //! Invoke `run_chunk(chunk)` for all chunks in [0, num_chunks), each on a separate thread (but the first one,
+    //! which is run on the calling thread), and join the threads. The function must not throw.
+    CPPLOT_INLINE void run_chunks(std::size_t num_chunks, const std::function<void(std::size_t)>& run_chunk);
+
+    //! Invoke `f(i)` for all i in [0, count) distributed over the available hardware threads.
+    //! The function must be thread-safe and must not interact with python.
+    template<std::invocable<std::size_t> F>
+    void parallel_for(std::size_t count, F&& f, std::size_t min_chunk_size = 1) {
+        const std::size_t max_threads = hardware_threads();
+        const std::size_t num_chunks = std::min(max_threads, std::max(count/std::max(min_chunk_size, std::size_t{1}), std::size_t{1}));
+        const std::size_t chunk_size = (count + num_chunks - 1)/num_chunks;
+
+        std::vector<std::exception_ptr> errors(num_chunks);
+        const auto run_chunk = [&] (std::size_t chunk) {
+            try {
+                for (std::size_t i = chunk*chunk_size; i < std::min(count, (chunk + 1)*chunk_size); ++i)
+                    f(i);
+            } catch (...) {
+                errors[chunk] = std::current_exception();
+            }
+        };
+
+        run_chunks(num_chunks, run_chunk);
+        for (const auto& error : errors)
+            if (error)
+                std::rethrow_exception(error);
+    }
+
+    //! Sample the function `f` on [x_min, x_max] such that the linear interpolant deviates from it by at most
+    //! `tolerance` (measured in coordinates normalized by the extents of the sampled curve). Starting from a
+    //! uniform sampling, intervals are bisected until their midpoints are within tolerance.
+    template<std::invocable<double> F>
+    std::pair<std::vector<double>, std::vector<double>> adaptive_sampling(F&& f,
+                                                                         double x_min,
+                                                                         double x_max,
+                                                                         double tolerance,
+                                                                         std::size_t initial_samples,
+                                                                         std::size_t max_refinements) {
+        initial_samples = std::max(initial_samples, std::size_t{2});
+        std::vector<double> x(initial_samples);
+        std::vector<double> y(initial_samples);
+        for (std::size_t i = 0; i < initial_samples; ++i)
+            x[i] = x_min + (x_max - x_min)*static_cast<double>(i)/static_cast<double>(initial_samples - 1);
+        parallel_for(x.size(), [&] (std::size_t i) { y[i] = static_cast<double>(f(x[i])); });
+
+        double y_min = std::numeric_limits<double>::max();
+        double y_max = std::numeric_limits<double>::lowest();
+        const auto update_y_range = [&] (const std::vector<double>& values) {
+            for (double v : values)
+                if (std::isfinite(v)) { y_min = std::min(y_min, v); y_max = std::max(y_max, v); }
+        };
+        const auto is_refined = [&] (std::size_t i, double xm, double ym) {
+            const int finite_count = std::isfinite(y[i]) + std::isfinite(ym) + std::isfinite(y[i+1]);
+            if (finite_count < 3)
+                return finite_count > 0;  // localize poles and gaps in the domain
+            const double sx = 1.0/(x_max - x_min);
+            const double sy = y_max > y_min ? 1.0/(y_max - y_min) : 1.0;
+            const double dx = (x[i+1] - x[i])*sx, dy = (y[i+1] - y[i])*sy;
+            const double cross = dx*(ym - y[i])*sy - dy*(xm - x[i])*sx;
+            return std::abs(cross) > tolerance*std::hypot(dx, dy);
+        };
+
+        update_y_range(y);
+        std::vector<bool> active(x.size() - 1, true);
+        for (std::size_t level = 0; level < max_refinements; ++level) {
+            std::vector<std::size_t> intervals;
+            for (std::size_t i = 0; i < active.size(); ++i)
+                if (active[i])
+                    intervals.push_back(i);
+            if (intervals.empty())
+                break;
+
+            std::vector<double> xm(intervals.size());
+            std::vector<double> ym(intervals.size());
+            parallel_for(intervals.size(), [&] (std::size_t k) {
+                xm[k] = 0.5*(x[intervals[k]] + x[intervals[k] + 1]);
+                ym[k] = static_cast<double>(f(xm[k]));
+            });
+            update_y_range(ym);
+
+            std::vector<double> new_x, new_y;
+            std::vector<bool> new_active;
+            for (std::size_t i = 0, k = 0; i < active.size(); ++i) {
+                new_x.push_back(x[i]);
+                new_y.push_back(y[i]);
+                if (active[i] && is_refined(i, xm[k], ym[k])) {
+                    new_x.push_back(xm[k]);
+                    new_y.push_back(ym[k]);
+                    new_active.insert(new_active.end(), {true, true});
+                } else {
+                    new_active.push_back(false);
+                }
+                k += active[i];
+            }
+            new_x.push_back(x.back());
+            new_y.push_back(y.back());
+            x = std::move(new_x);
+            y = std::move(new_y);
+            active = std::move(new_active);
+        }
+        return {std::move(x), std::move(y)};
     }
 
+    //! Data structure to store the coordinates of a polyline or polygon
+    struct polyline {
+        std::vector<double> x;
+        std::vector<double> y;
+    };
+
+    template<std::ranges::range R>
+    std::vector<double> to_double_vector(R&& values) {
+        std::vector<double> result;
+        if constexpr (std::ranges::sized_range<R>)
+            result.reserve(std::ranges::size(values));
+        for (const auto& value : values)
+            result.push_back(static_cast<double>(value));
+        return result;
+    }
+
+    //! Distance of a point to the segment [a, b] after scaling the coordinates with the given factors
+    CPPLOT_INLINE double segment_distance(const polyline& line, std::size_t i, std::size_t a, std::size_t b, const std::array<double, 2>& scale);
+
+    //! Mark the points of the polyline section [first, last] that are kept by the Douglas-Peucker algorithm
+    CPPLOT_INLINE void mark_douglas_peucker(const polyline& line,
+                                            std::size_t first,
+                                            std::size_t last,
+                                            const std::array<double, 2>& scale,
+                                            double tolerance,
+                                            std::vector<bool>& keep);
+
+    CPPLOT_INLINE polyline select(const polyline& line, const std::vector<bool>& keep);
+
+    //! Remove the parts of a polyline that lie outside of the given box. Segments that may intersect the box are kept,
+    //! including their end points beyond the box, such that the visible part of the line is unaffected. Gaps between
+    //! the remaining parts are marked by non-finite values, which matplotlib does not connect.
+    CPPLOT_INLINE polyline clip_polyline(const polyline& line, std::array<double, 2> x_limits, std::array<double, 2> y_limits);
+
+    //! Simplify a polyline with the Douglas-Peucker algorithm. Non-finite values, which matplotlib interprets
+    //! as gaps in the line, are kept and each of the connected parts is simplified individually.
+    CPPLOT_INLINE polyline simplify_polyline(const polyline& line, const std::array<double, 2>& scale, double tolerance);
+
+    //! Simplify a closed polygon with the Douglas-Peucker algorithm, keeping at least a triangle
+    CPPLOT_INLINE polyline simplify_polygon(const polyline& polygon, const std::array<double, 2>& scale, double tolerance);
+
+    //! Greedily select boxes (x_min, y_min, x_max, y_max) in the given order, skipping those that overlap with any of
+    //! the previously selected ones. Candidates are looked up in a uniform grid with cells of the size of the boxes.
+    CPPLOT_INLINE std::vector<bool> select_non_overlapping(const std::vector<std::array<double, 4>>& boxes, double cell_size);
+
+    //! Add the segment from (x0, y0) to (x1, y1), given in pixel coordinates with pixel centers at integer values,
+    //! to the image with row-major layout. Each step along the major direction distributes the covered length onto
+    //! the two pixels closest to the line in the minor direction (anti-aliasing in the spirit of Wu's algorithm).
+    CPPLOT_INLINE void accumulate_segment(std::span<float> image, const grid& size, double x0, double y0, double x1, double y1);
+
+    //! Rearrange the given values such that the elements at the given (sorted, unique) ranks are those that would be there
+    //! if the values were sorted. The selection recurses into both sides of each selected rank, which are processed
+    //! in parallel for the given number of recursion levels.
+    CPPLOT_INLINE void multi_select(std::span<double> values,
+                                    std::span<const std::size_t> ranks,
+                                    std::size_t offset = 0,
+                                    unsigned parallel_levels = 0);
+
     struct plt {
         pyobject pyplot;
 
         plt() : pyplot{} {
-            pyplot = pyobject::from(PyImport_ImportModule("matplotlib.pyplot"));
+            pyplot = pyobject::from(capi::import_module("matplotlib.pyplot"));
             if (!pyplot)
                 throw exceptions::python_error("Could not import matplotlib.pyplot.");
         }
@@ -382,10 +732,26 @@ inline kwarg<none> kw(std::string name) noexcept {
     return {std::move(name)};
 }
 
+//! Wrapper around an invocable that is passed to python as a callable (see `callback`)
+template<typename F>
+struct py_callback {
+    F function;
+};
+
+//! Wrap an invocable such that it can be passed to python as a callable in args or kwargs (e.g. as tick formatter
+//! or event handler). The python arguments are converted into the parameter types of the invocable (scalars,
+//! `std::string`, `pyobject`, or `std::optional` thereof for arguments that may be `None`), surplus arguments are
+//! ignored, and the return value is converted into a python object. Exceptions are raised as `RuntimeError`.
+template<typename F>
+    requires(requires (F f) { std::function{f}; })
+inline auto callback(F&& f) {
+    return py_callback<std::decay_t<F>>{std::forward<F>(f)};
+}
+
 namespace literals {
 
 //! Create a keyword argument from a string literal
-kwarg<none> operator ""_kw(const char* chars, size_t size) noexcept {
+inline kwarg<none> operator ""_kw(const char* chars, size_t size) noexcept {
     std::string n;
     n.resize(size);
     std::copy_n(chars, size, n.begin());
@@ -394,6 +760,216 @@ kwarg<none> operator ""_kw(const char* chars, size_t size) noexcept {
 
 }  // namespace literals
 
+#ifndef DOXYGEN
+namespace detail {
+
+    CPPLOT_INLINE pyobject numpy();
+
+    //! Return the resident set size of this process in bytes (or 0 if it cannot be determined on this platform)
+    CPPLOT_INLINE std::size_t resident_set_size();
+
+    CPPLOT_INLINE std::size_t allocated_python_blocks();
+
+    //! Value types that can be stored in a `pybuffer`
+    template<typename T>
+    concept buffer_value = concepts::scalar<T> or is_complex<T>::value;
+
+    //! Return the numpy dtype string for the given value type
+    template<buffer_value T>
+    std::string dtype() {
+        if constexpr (is_complex<T>::value)
+            return "c" + std::to_string(sizeof(T));
+        else if constexpr (std::is_same_v<T, bool>)
+            return "?";
+        else if constexpr (std::floating_point<T>)
+            return "f" + std::to_string(sizeof(T));
+        else if constexpr (std::signed_integral<T>)
+            return "i" + std::to_string(sizeof(T));
+        else
+            return "u" + std::to_string(sizeof(T));
+    }
+
+    //! Contiguous buffer allocated on the python side, into which values can be written directly from C++.
+    //! The buffer is handed over to numpy without copying.
+    template<buffer_value T>
+    class pybuffer {
+     public:
+        explicit pybuffer(std::size_t size) : _size{size} {
+            pycontext{};
+            _bytes = pyobject::from(capi::new_bytearray(size*sizeof(T)));
+            _data = reinterpret_cast<T*>(capi::bytearray_data(_bytes.get()));  // the bytearray is never resized
+        }
+
+        //! Return a view on the values in this buffer
+        std::span<T> values() const noexcept {
+            return {_data, _size};
+        }
+
+        //! Return a numpy array of the given shape that shares the memory of this buffer
+        pyobject array(const std::vector<std::size_t>& shape) const {
+            auto flat = pycall(numpy(), "frombuffer", args(_bytes), kwargs(kw("dtype") = dtype<T>()));
+            return flat && shape.size() > 1 ? pycall(flat, "reshape", args(shape)) : flat;
+        }
+
+     private:
+        std::size_t _size;
+        pyobject _bytes;
+        T* _data;
+    };
+
+    CPPLOT_INLINE pyobject get_attribute(const pyobject& obj, const std::string& name);
+
+    //! Return the limits returned by the given getter (e.g. get_xlim) of the given axis
+    CPPLOT_INLINE std::array<double, 2> get_limits(const pyobject& ax, const std::string& getter);
+
+    //! Return the width and height of the given axis in pixels
+    CPPLOT_INLINE std::array<double, 2> get_size_in_pixels(const pyobject& ax);
+
+    //! Return the limits of the given axis in the given direction ("x" or "y") if they are fixed, i.e. not autoscaled
+    CPPLOT_INLINE std::array<double, 2> get_fixed_limits(const pyobject& ax, const std::string& dir);
+
+    //! Signature of C++ functions that can be called from python (they receive the tuple of positional arguments)
+    using pyfunction = std::function<pyobject(const pyobject&)>;
+
+    //! Create a python callable that invokes the given function, whose lifetime is managed by the python object.
+    //! Exceptions thrown by the function are translated into a python `RuntimeError`.
+    CPPLOT_INLINE pyobject make_pycallable(pyfunction f);
+
+    template<typename F>
+    struct function_signature : function_signature<decltype(std::function{std::declval<F>()})> {};
+    template<typename R, typename... A>
+    struct function_signature<std::function<R(A...)>> {
+        using result = R;
+        using arguments = std::tuple<std::remove_cvref_t<A>...>;
+    };
+
+    //! Create a python callable from the given invocable, converting the arguments into its parameter types
+    template<typename F>
+    pyobject make_pycallable_from(F f) {
+        using result = typename function_signature<F>::result;
+        using arguments = typename function_signature<F>::arguments;
+        return make_pycallable([f = std::move(f)] (const pyobject& args) mutable -> pyobject {
+            constexpr std::size_t arity = std::tuple_size_v<arguments>;
+            const auto size = static_cast<std::size_t>(capi::sequence_size(args.get()));
+            if (size < arity)
+                throw exceptions::size_error(
+                    "Callback expects " + std::to_string(arity) + " arguments, but received " + std::to_string(size)
+                );
+            return [&] <std::size_t... i> (std::index_sequence<i...>) -> pyobject {
+                const auto invoke = [&] () -> decltype(auto) {
+                    return std::invoke(f, from_pyobject<std::tuple_element_t<i, arguments>>(
+                        pyobject::from(capi::sequence_get(args.get(), i))
+                    )...);
+                };
+                if constexpr (std::is_void_v<result>) {
+                    invoke();
+                    return pyobject{};
+                } else if constexpr (std::is_same_v<std::remove_cvref_t<result>, pyobject>) {
+                    return invoke();
+                } else {
+                    return to_pyobject(invoke());
+                }
+            }(std::make_index_sequence<arity>{});
+        });
+    }
+
+    //! Return the number of pixels per data unit (in x and y) on the given (linear) axis, assuming that the axis
+    //! limits will be autoscaled (where enabled) to include the given polyline.
+    CPPLOT_INLINE std::array<double, 2> pixels_per_unit(const pyobject& ax, const polyline& line);
+
+    //! Let the given line draw the values of the given arrays of persistent buffers (see `refresh`)
+    CPPLOT_INLINE void bind_line_buffers(const pyobject& line, const pyobject& x, const pyobject& y);
+
+    //! Let the given image draw the values of the given array of a persistent buffer (see `refresh`)
+    CPPLOT_INLINE void bind_image_buffer(const pyobject& image, const pyobject& values);
+
+}  // namespace detail
+#endif  // DOXYGEN
+
+//! Buffer that is allocated once on the python side and written to directly from C++, e.g. to hold the data of a
+//! live plot that changes in every frame. When passed to python, it always yields the same numpy array (sharing the
+//! memory of this buffer), i.e. the conversion neither copies the values nor allocates any python objects. The array
+//! covers the full capacity, with values beyond the current size set to NaN, which matplotlib does not draw.
+//! Lines and images created from persistent buffers (see `axis::plot` and `axis::imshow`) are bound to them, and
+//! `refresh` shows the current contents of the buffers at the next draw without allocating python objects.
+template<std::floating_point T>
+class persistent_buffer {
+ public:
+    //! Create a one-dimensional buffer that can hold up to the given number of values
+    explicit persistent_buffer(std::size_t capacity)
+    : persistent_buffer{capacity, {capacity}}
+    {}
+
+    //! Create a two-dimensional buffer (e.g. for images), whose size always equals the capacity
+    explicit persistent_buffer(const grid& shape)
+    : persistent_buffer{shape.rows*shape.cols, {shape.rows, shape.cols}} {
+        _size = _buffer.values().size();
+    }
+
+    persistent_buffer(const persistent_buffer&) = delete;
+    persistent_buffer(persistent_buffer&&) = default;
+    persistent_buffer& operator=(const persistent_buffer&) = delete;
+    persistent_buffer& operator=(persistent_buffer&&) = default;
+
+    //! Return the maximum number of values
+    std::size_t capacity() const noexcept {
+        return _buffer.values().size();
+    }
+
+    //! Return the number of valid values
+    std::size_t size() const noexcept {
+        return _size;
+    }
+
+    //! Return the valid values
+    std::span<T> values() const noexcept {
+        return _buffer.values().first(_size);
+    }
+
+    //! Set the number of valid values. Values beyond the new size are set to NaN, i.e. values added when growing are
+    //! NaN until they are written.
+    void resize(std::size_t size) {
+        if (size > capacity())
+            throw exceptions::size_error("Size exceeds the capacity of the buffer");
+        if (size < _size)
+            std::ranges::fill(_buffer.values().subspan(size, _size - size), std::numeric_limits<T>::quiet_NaN());
+        _size = size;
+    }
+
+    //! Copy the given values into the buffer and resize it accordingly
+    template<std::ranges::sized_range R>
+        requires(concepts::scalar<std::ranges::range_value_t<R>>)
+    void assign(R&& values) {
+        resize(std::ranges::size(values));
+        std::ranges::transform(values, _buffer.values().begin(), [] (const auto& v) { return static_cast<T>(v); });
+    }
+
+    //! Return the numpy array that shares the memory of this buffer
+    const pyobject& array() const noexcept {
+        return _array;
+    }
+
+ private:
+    persistent_buffer(std::size_t capacity, const std::vector<std::size_t>& shape)
+    : _buffer{capacity}
+    , _size{0} {
+        std::ranges::fill(_buffer.values(), std::numeric_limits<T>::quiet_NaN());
+        _array = _buffer.array(shape);
+    }
+
+    detail::pybuffer<T> _buffer;
+    std::size_t _size;
+    pyobject _array;
+};
+
+//! Show the current contents of the persistent buffers bound to the given artist (a line or an image created from
+//! persistent buffers via `axis::plot` or `axis::imshow`) at the next draw. Images draw the memory of their buffer
+//! directly, while lines draw from an interleaved copy of their buffers, which is updated in place. Thus, steady-state
+//! frames (writing into the buffers, calling refresh and drawing) do not allocate any new data arrays. Other artists
+//! are only marked stale.
+CPPLOT_INLINE void refresh(const pyobject& artist);
+
+
 //! Invoke a function on the given python object (may be used for non-exposed pyplot features)
 template<typename... A, typename... K>
 pyobject py_invoke(const pyobject& obj,
@@ -407,14 +983,134 @@ pyobject py_invoke(const pyobject& obj,
 }
 
 //! Return the `matplotlib.pyplot` module
-pyobject pyplot() {
-    return detail::plt{}.pyplot;
-}
+CPPLOT_INLINE pyobject pyplot();
 
 //! Show all currently active figures
-void show() {
-    detail::plt plt{};
-    detail::pycall(plt.pyplot, "show");
+CPPLOT_INLINE void show();
+
+//! Set the policy for managing python-side memory, which is applied whenever a figure is closed
+CPPLOT_INLINE void set_memory_policy(const memory_policy& policy);
+
+//! Return the current memory policy
+CPPLOT_INLINE memory_policy get_memory_policy();
+
+//! Collect garbage, clear matplotlib's internal caches and return freed memory to the system where possible
+CPPLOT_INLINE memory_report trim_memory();
+
+//! Move all objects currently tracked by python's garbage collector into a permanent generation that is ignored in
+//! future collections (useful after setting up long-lived objects, see python's gc.freeze)
+CPPLOT_INLINE void freeze_gc();
+
+//! Disable python's garbage collector until the returned object goes out of scope (e.g. while building many figures)
+[[nodiscard]] CPPLOT_INLINE detail::python::gc_pause pause_gc();
+
+//! Information on the matplotlib setup prepared by `warm_up_cache`
+struct cache_info {
+    std::string config_dir;
+    std::string cache_dir;
+    std::string backend;
+};
+
+//! Build matplotlib's font cache and persist the resolved backend, such that later processes start up fast.
+//! This is meant to be run at image-build time, with `MPLCONFIGDIR` (or the `CPPLOT_MPLCONFIGDIR` definition)
+//! pointing to the directory that is used at runtime (see tools/warm_up_cache.cpp). An existing
+//! `matplotlibrc` in the config directory is left untouched.
+CPPLOT_INLINE cache_info warm_up_cache();
+
+//! Python-side timings of a function recorded by `profile` (times in seconds)
+struct profile_entry {
+    std::string file;
+    std::size_t line;
+    std::string function;
+    std::size_t calls;
+    double total_time;  //!< time spent in the function itself
+    double cumulative_time;  //!< time spent in the function including the functions it called
+};
+
+//! Timings of the `draw` methods of an artist type recorded by `profile` (times in seconds)
+struct artist_profile_entry {
+    std::string artist;
+    std::size_t calls;
+    double cumulative_time;  //!< includes the time spent drawing child artists
+};
+
+//! Result of `profile`
+struct profile_report {
+    std::vector<profile_entry> functions;  //!< sorted by cumulative time in descending order
+    std::vector<artist_profile_entry> artists;  //!< sorted by cumulative time in descending order
+};
+
+//! Options for `profile`
+struct profile_options {
+    std::string pstats_file = "";  //!< if given, the raw statistics are written to this file (see python's pstats)
+    std::size_t max_functions = 50;  //!< maximum number of functions in the report (0 = all)
+};
+
+//! Run the given action under python's profiler and return the timings of the python functions it invoked, as well as
+//! the aggregated draw timings per artist type (e.g. to find out which artists make `figure::save_to` slow).
+template<std::invocable F>
+profile_report profile(F&& action, const profile_options& opts = {}) {
+    static const pyobject start = detail::define_pyfunction("start", R"(
+def start():
+    import cProfile
+    profiler = cProfile.Profile()
+    profiler.enable()
+    return profiler
+)");
+    static const pyobject stop = detail::define_pyfunction("stop", R"(
+def stop(profiler, pstats_file, max_functions):
+    import inspect, pstats, matplotlib.artist
+    profiler.disable()
+    if pstats_file:
+        profiler.dump_stats(pstats_file)
+    stats = pstats.Stats(profiler).stats
+
+    functions = sorted(
+        ((file, line, name, calls, total, cumulative) for (file, line, name), (_, calls, total, cumulative, _) in stats.items()),
+        key=lambda entry: entry[5],
+        reverse=True
+    )
+
+    draw_methods = {}
+    def collect_draw_methods(cls):
+        draw = cls.__dict__.get("draw")
+        code = getattr(inspect.unwrap(draw), "__code__", None) if draw is not None else None
+        if code is not None:
+            draw_methods.setdefault((code.co_filename, code.co_firstlineno), cls.__name__)
+        for subclass in cls.__subclasses__():
+            collect_draw_methods(subclass)
+    collect_draw_methods(matplotlib.artist.Artist)
+
+    artists = {}
+    for file, line, _, calls, _, cumulative in functions:
+        if (file, line) in draw_methods:
+            name = draw_methods[(file, line)]
+            previous = artists.get(name, (0, 0.0))
+            artists[name] = (previous[0] + calls, previous[1] + cumulative)
+    artists = sorted(((name, calls, cumulative) for name, (calls, cumulative) in artists.items()), key=lambda a: a[2], reverse=True)
+    return functions[:max_functions] if max_functions > 0 else functions, artists
+)");
+
+    auto profiler = detail::pycall(start, no_args);
+    try {
+        std::invoke(std::forward<F>(action));
+    } catch (...) {
+        detail::pycall(profiler, "disable");
+        throw;
+    }
+
+    using function_stats = std::tuple<std::string, std::size_t, std::string, std::size_t, double, double>;
+    using artist_stats = std::tuple<std::string, std::size_t, double>;
+    const auto [functions, artists] = detail::from_pyobject<std::tuple<std::vector<function_stats>, std::vector<artist_stats>>>(
+        detail::pycall(stop, args(profiler, opts.pstats_file, opts.max_functions))
+    );
+
+    profile_report report;
+    for (const auto& [file, line, function, calls, total_time, cumulative_time] : functions)
+        report.functions.push_back({file, line, function, calls, total_time, cumulative_time});
+    for (const auto& [artist, calls, cumulative_time] : artists)
+        report.artists.push_back({artist, calls, cumulative_time});
+    return report;
 }
 
 //! Options for `axis.imshow`
@@ -427,6 +1123,113 @@ struct bar_options {
     bool add_bar_labels = false;
 };
 
+//! Options for `axis.plot`
+struct plot_options {
+    double simplify_tolerance = 0.0;  //!< if > 0, the line is simplified with this tolerance in pixels
+    bool clip_to_view = false;  //!< if true, data outside of the fixed (i.e. not autoscaled) axis limits is skipped
+};
+
+//! Options for `axis.fill`
+struct fill_options {
+    double simplify_tolerance = 0.0;  //!< if > 0, the polygon is simplified with this tolerance in pixels
+};
+
+//! Options for `axis.annotate_many`
+struct annotate_options {
+    bool cull_overlaps = false;  //!< if true, labels overlapping with preceding ones at the current view are dropped
+    double font_size = 0.0;  //!< font size (in points) for estimating label extents (0 = fontsize from kwargs or rc)
+};
+
+//! Options for `axis.ecdf`
+struct ecdf_options {
+    std::size_t points = 0;  //!< number of equidistant probabilities to evaluate (0 = height of the axis in pixels)
+    std::size_t tail_points_per_decade = 10;  //!< additional points per decade of 1 - p, resolving high percentiles
+    bool complementary = false;  //!< plot the complementary ECDF, i.e. the fraction of values not below x
+};
+
+//! Options for `axis.plot_quantile_band`
+struct quantile_band_options {
+    std::vector<double> quantiles = {0.5, 0.9, 0.99};  //!< quantiles drawn as lines, with bands between neighbors
+    double band_alpha = 0.2;  //!< opacity of the bands
+};
+
+//! Window functions applied to the frames of a spectrogram
+enum class window_function {
+    rectangular,
+    hann,
+    hamming,
+    blackman
+};
+
+//! Options for `axis.spectrogram`
+struct spectrogram_options {
+    std::size_t frame_size = 256;  //!< samples per frame (zero-padded to the next power of two for the FFT)
+    std::size_t overlap = 128;  //!< number of samples shared by consecutive frames
+    window_function window = window_function::hann;
+    bool decibels = true;  //!< show the power spectral density in dB instead of linear scale
+    bool add_colorbar = false;
+};
+
+#ifndef DOXYGEN
+namespace detail {
+
+    //! Return the coefficients of the given window function for a frame of the given size
+    CPPLOT_INLINE std::vector<double> window_coefficients(window_function window, std::size_t size);
+
+}  // namespace detail
+#endif  // DOXYGEN
+
+//! Options for `axis.plot_mean_band`
+struct mean_band_options {
+    double standard_deviations = 1.0;  //!< half-width of the band in standard deviations
+    double band_alpha = 0.2;  //!< opacity of the band
+};
+
+//! Options for `axis.imshow_mosaic`
+struct mosaic_options {
+    std::size_t columns = 0;  //!< number of tiles per row (0 = approximately square layout)
+    std::size_t padding = 1;  //!< number of pixels between tiles (filled with NaN, i.e. the colormap's "bad" color)
+    bool normalize_tiles = true;  //!< scale the values of each tile to [0, 1] individually
+    std::vector<std::string> labels = {};  //!< optional labels placed at the upper left corner of the tiles
+    bool add_colorbar = false;
+};
+
+
+//! Options for `axis.line_density`
+struct line_density_options {
+    grid resolution = {.rows = 512, .cols = 512};  //!< resolution of the density image
+    bool add_colorbar = false;
+};
+
+//! Options for `axis.plot_function`
+struct plot_function_options {
+    std::size_t initial_samples = 33;  //!< number of uniform samples to start from (finer features may be missed)
+    std::size_t max_refinements = 16;  //!< maximum number of times an initial interval is bisected
+};
+
+// forward declarations of the types defined in the optional feature headers
+class lod_series;  // cpplot/lod.hpp
+class streaming_quantiles;  // cpplot/statistics.hpp
+class streaming_moments;  // cpplot/statistics.hpp
+
+#ifndef DOXYGEN
+namespace detail {
+
+    // tags of the optional feature headers that implement members of axis
+    struct lod_header;
+    struct statistics_header;
+    struct mosaic_header;
+    struct spectrogram_header;
+    struct line_density_header;
+
+    //! True if the feature header with the given tag has been included (specialized in the feature headers). The
+    //! dependent type defers the check to the instantiation of the axis member that requires the header.
+    template<typename Header, typename Dependent>
+    inline constexpr bool has_header = false;
+
+}  // namespace detail
+#endif  // DOXYGEN
+
 //! forward declaration
 class figure;
 
@@ -446,6 +1249,65 @@ class axis {
         return detail::pycall(_ax, "plot", args(std::forward<X>(x), std::forward<Y>(y)), kwargs);
     }
 
+    //! Plot the values of the given persistent buffers. The line is bound to the buffers, call `refresh` on it to
+    //! show later changes to their values.
+    template<std::floating_point X, std::floating_point Y, typename... K>
+    pyobject plot(const persistent_buffer<X>& x, const persistent_buffer<Y>& y, const py_kwargs<K...>& kwargs = no_kwargs) {
+        auto lines = detail::pycall(_ax, "plot", args(x, y), kwargs);
+        if (lines)
+            detail::bind_line_buffers(pyobject::from(detail::capi::sequence_get(lines.get(), 0)), x.array(), y.array());
+        return lines;
+    }
+
+    //! Plot the given values against indices on the x-axis, processed according to the given options
+    template<std::ranges::sized_range Y, typename... K>
+        requires(concepts::scalar<std::ranges::range_value_t<Y>>)
+    pyobject plot(Y&& y, const py_kwargs<K...>& kwargs, const plot_options& opts) {
+        const auto x = std::views::iota(std::size_t{0}, std::ranges::size(y));
+        return plot(x, std::forward<Y>(y), kwargs, opts);
+    }
+
+    //! Plot the given y-values against the given x-values, processed according to the given options
+    template<std::ranges::range X, std::ranges::range Y, typename... K>
+        requires(concepts::scalar<std::ranges::range_value_t<X>> and concepts::scalar<std::ranges::range_value_t<Y>>)
+    pyobject plot(X&& x, Y&& y, const py_kwargs<K...>& kwargs, const plot_options& opts) {
+        detail::polyline line{detail::to_double_vector(x), detail::to_double_vector(y)};
+        if (line.x.size() != line.y.size())
+            throw exceptions::size_error("Number of x and y values do not match");
+        if (opts.clip_to_view)
+            line = detail::clip_polyline(line, detail::get_fixed_limits(_ax, "x"), detail::get_fixed_limits(_ax, "y"));
+        if (opts.simplify_tolerance > 0.0)
+            line = detail::simplify_polyline(line, detail::pixels_per_unit(_ax, line), opts.simplify_tolerance);
+        return plot(line.x, line.y, kwargs);
+    }
+
+    //! Plot the given level-of-detail series, showing the current view at screen resolution. The line is updated
+    //! with the visible window whenever the x-limits of this axis change (requires cpplot/lod.hpp).
+    template<typename... K>
+    pyobject plot(const lod_series& series, const py_kwargs<K...>& kwargs = no_kwargs) {
+        static_assert(detail::has_header<detail::lod_header, py_kwargs<K...>>,
+                      "Plotting a lod_series requires #include <cpplot/lod.hpp>");
+        return _plot_lod_series(series, kwargs);
+    }
+
+    //! Plot the function `f` on the interval [x_min, x_max], adaptively choosing the sample points such that the
+    //! plotted curve deviates from `f` by at most `tolerance`, measured relative to the extents of the plot (e.g. a
+    //! tolerance of 1e-3 corresponds to one pixel on an axis that is 1000 pixels wide). The function is evaluated
+    //! in parallel and must therefore be thread-safe.
+    template<std::invocable<double> F, typename... K>
+        requires(std::convertible_to<std::invoke_result_t<F, double>, double>)
+    pyobject plot_function(F&& f,
+                           double x_min,
+                           double x_max,
+                           double tolerance = 1e-3,
+                           const py_kwargs<K...>& kwargs = no_kwargs,
+                           const plot_function_options& opts = {}) {
+        const auto [x, y] = detail::adaptive_sampling(
+            std::forward<F>(f), x_min, x_max, tolerance, opts.initial_samples, opts.max_refinements
+        );
+        return plot(x, y, kwargs);
+    }
+
     //! Plot a histogram on this axis
     template<std::ranges::range X, typename... K>
     pyobject hist(X&& x, const py_kwargs<K...>& kwargs = no_kwargs) {
@@ -457,15 +1319,118 @@ class axis {
     pyobject imshow(I&& img,
                     const py_kwargs<K...>& kwargs = no_kwargs,
                     const imshow_options& opts = {}) {
-        auto image = detail::pycall(_ax, "imshow", args(img), kwargs);
-        if (image && opts.add_colorbar)
-            detail::pycall(detail::plt{}.pyplot, "colorbar", no_args, cpplot::kwargs(
-                kw("mappable") = image,
-                kw("ax") = _ax
-            ));
+        return _imshow(detail::to_pyobject(img), kwargs, opts);
+    }
+
+    //! Show the image stored in the given (two-dimensional) persistent buffer. The image is bound to the buffer, call
+    //! `refresh` on it to show later changes to its values.
+    template<std::floating_point T, typename... K>
+    pyobject imshow(const persistent_buffer<T>& img,
+                    const py_kwargs<K...>& kwargs = no_kwargs,
+                    const imshow_options& opts = {}) {
+        auto image = _imshow(img.array(), kwargs, opts);
+        if (image)
+            detail::bind_image_buffer(image, img.array());
         return image;
     }
 
+    //! Show the given images as tiles of a single image (atlas), e.g. to inspect many small kernels or thumbnails
+    //! without creating an axis per image. The tiles are composed in parallel, and smaller images are padded to the
+    //! size of the largest one. The given kwargs are forwarded to imshow (requires cpplot/mosaic.hpp).
+    template<std::ranges::range R, typename... K>
+        requires(concepts::image<std::ranges::range_value_t<R>>)
+    pyobject imshow_mosaic(R&& images,
+                           const py_kwargs<K...>& kwargs = no_kwargs,
+                           const mosaic_options& opts = {}) {
+        static_assert(detail::has_header<detail::mosaic_header, R>,
+                      "axis::imshow_mosaic requires #include <cpplot/mosaic.hpp>");
+        return _imshow_mosaic(std::forward<R>(images), kwargs, opts);
+    }
+
+    //! Show the image obtained from evaluating `f` at all locations of the given grid.
+    //! The function is evaluated in parallel and must therefore be thread-safe.
+    template<std::invocable<const grid_location&> F, typename... K>
+        requires(concepts::scalar<std::invoke_result_t<F, const grid_location&>>)
+    pyobject imshow(const grid& grid,
+                    F&& f,
+                    const py_kwargs<K...>& kwargs = no_kwargs,
+                    const imshow_options& opts = {}) {
+        detail::pybuffer<std::remove_cvref_t<std::invoke_result_t<F, const grid_location&>>> image{grid.rows*grid.cols};
+        const auto values = image.values();
+        detail::parallel_for(values.size(), [&] (std::size_t i) {
+            values[i] = f(grid_location{.row = i/grid.cols, .col = i%grid.cols});
+        });
+        return _imshow(image.array({grid.rows, grid.cols}), kwargs, opts);
+    }
+
+    //! Plot the empirical cumulative distribution function of the given values. Instead of sorting all values, only
+    //! the order statistics at the evaluated probabilities are selected (in parallel), such that only these points
+    //! are passed to python. Besides equidistant probabilities, the upper tail is sampled logarithmically in 1 - p,
+    //! which resolves high percentiles (e.g. on a logarithmic scale for the complementary ECDF). NaNs are ignored.
+    //! Requires cpplot/statistics.hpp.
+    template<std::ranges::sized_range R, typename... K>
+        requires(concepts::scalar<std::ranges::range_value_t<R>>)
+    pyobject ecdf(R&& values, const py_kwargs<K...>& kwargs = no_kwargs, const ecdf_options& opts = {}) {
+        static_assert(detail::has_header<detail::statistics_header, R>,
+                      "axis::ecdf requires #include <cpplot/statistics.hpp>");
+        return _ecdf(std::forward<R>(values), kwargs, opts);
+    }
+
+    //! Plot the given quantiles over time as lines in the same color, with shaded bands between neighboring quantiles.
+    //! Buckets without samples leave gaps. The given kwargs are forwarded to the lines, and the lines are returned.
+    //! Requires cpplot/statistics.hpp.
+    template<typename... K>
+    pyobject plot_quantile_band(const streaming_quantiles& quantiles,
+                                const py_kwargs<K...>& kwargs = no_kwargs,
+                                const quantile_band_options& opts = {}) {
+        static_assert(detail::has_header<detail::statistics_header, py_kwargs<K...>>,
+                      "axis::plot_quantile_band requires #include <cpplot/statistics.hpp>");
+        return _plot_quantile_band(quantiles, kwargs, opts);
+    }
+
+    //! Plot the means of the given buckets as a line, with a shaded band of the given number of standard deviations
+    //! around it. Buckets without samples leave gaps. The given kwargs are forwarded to the line, which is returned.
+    //! Requires cpplot/statistics.hpp.
+    template<typename... K>
+    pyobject plot_mean_band(const streaming_moments& moments,
+                            const py_kwargs<K...>& kwargs = no_kwargs,
+                            const mean_band_options& opts = {}) {
+        static_assert(detail::has_header<detail::statistics_header, py_kwargs<K...>>,
+                      "axis::plot_mean_band requires #include <cpplot/statistics.hpp>");
+        return _plot_mean_band(moments, kwargs, opts);
+    }
+
+    //! Show the spectrogram (power spectral density over time) of the given signal sampled at the given rate. The
+    //! windowed FFTs of all frames are computed in parallel, and the image is shown via imshow with time (in units
+    //! of 1/sample_rate) on the x-axis and frequency on the y-axis. The given kwargs are forwarded to imshow.
+    //! Requires cpplot/spectrogram.hpp.
+    template<std::ranges::sized_range R, typename... K>
+        requires(concepts::scalar<std::ranges::range_value_t<R>>)
+    pyobject spectrogram(R&& signal,
+                         double sample_rate,
+                         const py_kwargs<K...>& kwargs = no_kwargs,
+                         const spectrogram_options& opts = {}) {
+        static_assert(detail::has_header<detail::spectrogram_header, R>,
+                      "axis::spectrogram requires #include <cpplot/spectrogram.hpp>");
+        return _spectrogram(std::forward<R>(signal), sample_rate, kwargs, opts);
+    }
+
+    //! Show the density of the given lines (a range of ranges of points), obtained by rasterizing all lines with
+    //! anti-aliasing and additive accumulation into an image, which is shown via imshow. Lines are rasterized in
+    //! parallel, and the image covers the fixed axis limits or the extents of the data where the axis autoscales.
+    //! The given kwargs are forwarded to imshow (e.g. to set the colormap or a logarithmic norm).
+    //! Requires cpplot/line_density.hpp.
+    template<std::ranges::random_access_range L, typename... K>
+        requires(std::ranges::forward_range<std::ranges::range_value_t<L>>
+                 and concepts::point_2d<std::ranges::range_value_t<std::ranges::range_value_t<L>>>)
+    pyobject line_density(L&& lines,
+                          const py_kwargs<K...>& kwargs = no_kwargs,
+                          const line_density_options& opts = {}) {
+        static_assert(detail::has_header<detail::line_density_header, L>,
+                      "axis::line_density requires #include <cpplot/line_density.hpp>");
+        return _line_density(std::forward<L>(lines), kwargs, opts);
+    }
+
     //! Add a bar plot to this axis using the data point indices on the x-axis
     template<std::ranges::sized_range Y, typename... K>
     pyobject bar(Y&& y,
@@ -489,13 +1454,66 @@ class axis {
     //! Draw a polygon by connecting the points in the given range and fill its interior
     template<std::ranges::forward_range R, typename... K>
         requires(concepts::point_2d<std::ranges::range_value_t<R>>)
-    pyobject fill(R&& corners, const py_kwargs<K...>& kwargs = no_kwargs) {
+    pyobject fill(R&& corners, const py_kwargs<K...>& kwargs = no_kwargs, const fill_options& opts = {}) {
+        if (opts.simplify_tolerance > 0.0) {
+            detail::polyline polygon{
+                detail::to_double_vector(corners | std::views::transform([] <typename P> (const P& point) { return traits::point_access<P, 0>::get(point); })),
+                detail::to_double_vector(corners | std::views::transform([] <typename P> (const P& point) { return traits::point_access<P, 1>::get(point); }))
+            };
+            polygon = detail::simplify_polygon(polygon, detail::pixels_per_unit(_ax, polygon), opts.simplify_tolerance);
+            return detail::pycall(_ax, "fill", args(polygon.x, polygon.y), kwargs);
+        }
         return detail::pycall(_ax, "fill", args(
             corners | std::views::transform([] <typename P> (const P& point) { return traits::point_access<P, 0>::get(point); }),
             corners | std::views::transform([] <typename P> (const P& point) { return traits::point_access<P, 1>::get(point); })
         ), kwargs);
     }
 
+    //! Annotate all given positions with the corresponding labels in a single call, optionally dropping labels that
+    //! would overlap with preceding ones or lie outside of the axis. Overlaps are determined at the current view and
+    //! figure size (in display coordinates, i.e. for any axis scale), with label extents estimated from the font size
+    //! (default text alignment is assumed). The given kwargs are forwarded to each invocation of
+    //! pyplot.Axes.annotate. Returns the list of created annotations.
+    template<std::ranges::range P, std::ranges::range L, typename... K>
+        requires(concepts::point_2d<std::ranges::range_value_t<P>>
+                 and std::constructible_from<std::string, std::ranges::range_value_t<L>>)
+    pyobject annotate_many(P&& positions,
+                           L&& labels,
+                           const py_kwargs<K...>& kwargs = no_kwargs,
+                           const annotate_options& opts = {}) {
+        std::vector<double> x = detail::to_double_vector(positions | std::views::transform([] <typename T> (const T& p) {
+            return traits::point_access<T, 0>::get(p);
+        }));
+        std::vector<double> y = detail::to_double_vector(positions | std::views::transform([] <typename T> (const T& p) {
+            return traits::point_access<T, 1>::get(p);
+        }));
+        std::vector<std::string> texts;
+        for (const auto& label : labels)
+            texts.emplace_back(label);
+        if (texts.size() != x.size())
+            throw exceptions::size_error("Number of positions and labels do not match");
+
+        if (opts.cull_overlaps) {
+            const auto selected = _select_non_overlapping_labels(x, y, texts, kwargs, opts.font_size);
+            std::size_t count = 0;
+            for (std::size_t i = 0; i < selected.size(); ++i)
+                if (selected[i]) {
+                    x[count] = x[i];
+                    y[count] = y[i];
+                    texts[count++] = std::move(texts[i]);
+                }
+            x.resize(count);
+            y.resize(count);
+            texts.resize(count);
+        }
+
+        static const pyobject annotate = detail::define_pyfunction("annotate_many", R"(
+def annotate_many(ax, labels, x, y, **kwargs):
+    return [ax.annotate(label, (xi, yi), **kwargs) for label, xi, yi in zip(labels, x, y)]
+)");
+        return detail::pycall(annotate, args(_ax, texts, x, y), kwargs);
+    }
+
     //! Add a title to this axis
     pyobject set_title(const std::string& title) {
        return detail::pycall(_ax, "set_title", args(title));
@@ -513,6 +1531,16 @@ class axis {
         return detail::pycall(_ax, "set_yticks", args(ticks), kwargs);
     }
 
+    //! Set the x-axis limits (disables autoscaling in x-direction)
+    pyobject set_x_limits(double min, double max) {
+        return detail::pycall(_ax, "set_xlim", args(min, max));
+    }
+
+    //! Set the y-axis limits (disables autoscaling in y-direction)
+    pyobject set_y_limits(double min, double max) {
+        return detail::pycall(_ax, "set_ylim", args(min, max));
+    }
+
     //! Set the x-axis label
     pyobject set_x_label(const std::string& label) {
          return detail::pycall(_ax, "set_xlabel", args(label), py_kwargs<>{});
@@ -545,6 +1573,85 @@ class axis {
  private:
     friend class figure;
     axis(pyobject ax) : _ax{ax} {}
+
+    template<typename... K>
+    std::vector<bool> _select_non_overlapping_labels(const std::vector<double>& x,
+                                                     const std::vector<double>& y,
+                                                     const std::vector<std::string>& labels,
+                                                     const py_kwargs<K...>& kwargs,
+                                                     double font_size) const {
+        static const pyobject label_anchors = detail::define_pyfunction("label_anchors", R"(
+def label_anchors(ax, x, y, fontsize=None, size=None, **kwargs):
+    import numpy as np
+    from matplotlib.font_manager import FontProperties
+
+    font_size = FontProperties(size=fontsize if fontsize is not None else size).get_size_in_points()
+    points = ax.transData.transform(np.column_stack([np.asarray(x, dtype=float), np.asarray(y, dtype=float)]))
+    extent = ax.get_window_extent()
+    return font_size, points[:, 0].tolist(), points[:, 1].tolist(), (extent.x0, extent.y0, extent.x1, extent.y1)
+)");
+        using anchors = std::tuple<double, std::vector<double>, std::vector<double>, std::tuple<double, double, double, double>>;
+        const auto [kwargs_font_size, px, py, extent] = detail::from_pyobject<anchors>(
+            detail::pycall(label_anchors, args(_ax, x, y), kwargs)
+        );
+        if (font_size <= 0.0)
+            font_size = kwargs_font_size;
+        const auto figure = detail::get_attribute(_ax, "figure");
+        const double pixels_per_point = detail::from_pyobject<double>(detail::get_attribute(figure, "dpi"))/72.0;
+        const double char_width = 0.6*font_size*pixels_per_point;
+        const double line_height = 1.2*font_size*pixels_per_point;
+        const auto [x0, y0, x1, y1] = extent;
+
+        double max_width = 0.0;
+        constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+        std::vector<std::array<double, 4>> boxes(px.size());
+        for (std::size_t i = 0; i < px.size(); ++i) {
+            const double width = char_width*static_cast<double>(labels[i].size());
+            boxes[i] = {px[i], py[i], px[i] + width, py[i] + line_height};
+            // labels whose box lies outside of the axis are culled (marked by non-finite boxes)
+            if (!(boxes[i][2] > x0 && boxes[i][0] < x1 && boxes[i][3] > y0 && boxes[i][1] < y1))
+                boxes[i] = {nan, nan, nan, nan};
+            else
+                max_width = std::max(max_width, width);
+        }
+        return detail::select_non_overlapping(boxes, std::max(max_width, line_height));
+    }
+
+    // implementations of the members that require optional feature headers (defined in these headers)
+    template<typename... K>
+    pyobject _plot_lod_series(const lod_series& series, const py_kwargs<K...>& kwargs);
+    template<typename R, typename... K>
+    pyobject _imshow_mosaic(R&& images, const py_kwargs<K...>& kwargs, const mosaic_options& opts);
+    template<typename R, typename... K>
+    pyobject _ecdf(R&& values, const py_kwargs<K...>& kwargs, const ecdf_options& opts);
+    template<typename... K>
+    pyobject _plot_quantile_band(const streaming_quantiles& quantiles,
+                                 const py_kwargs<K...>& kwargs,
+                                 const quantile_band_options& opts);
+    template<typename... K>
+    pyobject _plot_mean_band(const streaming_moments& moments,
+                             const py_kwargs<K...>& kwargs,
+                             const mean_band_options& opts);
+    template<typename R, typename... K>
+    pyobject _spectrogram(R&& signal, double sample_rate, const py_kwargs<K...>& kwargs, const spectrogram_options& opts);
+    template<typename L, typename... K>
+    pyobject _line_density(L&& lines, const py_kwargs<K...>& kwargs, const line_density_options& opts);
+
+    std::size_t _width_in_pixels() const {
+        return static_cast<std::size_t>(std::max(detail::get_size_in_pixels(_ax)[0], 1.0));
+    }
+
+    template<typename... K>
+    pyobject _imshow(const pyobject& img, const py_kwargs<K...>& kwargs, const imshow_options& opts) {
+        auto image = detail::pycall(_ax, "imshow", args(img), kwargs);
+        if (image && opts.add_colorbar)
+            detail::pycall(detail::plt{}.pyplot, "colorbar", no_args, cpplot::kwargs(
+                kw("mappable") = image,
+                kw("ax") = _ax
+            ));
+        return image;
+    }
+
     pyobject _ax;
 };
 
@@ -560,6 +1667,63 @@ struct style {
 //! default style
 inline constexpr style default_style{.name = "default"};
 
+//! Options for `figure::save_progressive`
+struct progressive_save_options {
+    double preview_dpi = 30.0;  //!< resolution of the preview
+    double dpi = 0.0;  //!< resolution of the full-quality output (0 = matplotlib's default savefig.dpi)
+};
+
+//! Handle to the full-quality render of a progressive save (see `figure::save_progressive`).
+//! The render runs in a separate python process, i.e. it progresses in parallel to the calling thread, independent
+//! of the GIL. The handle itself is not thread-safe and must only be used from the thread that uses cpplot.
+class [[nodiscard]] progressive_save {
+ public:
+    //! Blocks until the render process has finished (errors are discarded, call `wait` to observe them)
+    ~progressive_save() {
+        _finish();
+    }
+
+    progressive_save(const progressive_save&) = delete;
+    progressive_save(progressive_save&&) = default;
+    progressive_save& operator=(const progressive_save&) = delete;
+
+    //! Blocks until the render process of this handle has finished (as the destructor) before taking over the other one
+    progressive_save& operator=(progressive_save&& other) {
+        if (this != &other) {
+            _finish();
+            _render = std::exchange(other._render, pyobject{});
+        }
+        return *this;
+    }
+
+    //! Return true if the full-quality output has been written (or rendering failed)
+    bool ready() const {
+        return !_render || detail::from_pyobject<bool>(detail::pycall(_render, "ready"));
+    }
+
+    //! Block until the full-quality output has been written. Throws if rendering failed.
+    void wait() {
+        if (!_render)
+            return;
+        const auto render = std::exchange(_render, pyobject{});
+        const auto error = detail::from_pyobject<std::optional<std::string>>(detail::pycall(render, "wait"));
+        if (error)
+            throw exceptions::python_error("Progressive save failed: " + *error);
+    }
+
+ private:
+    friend class figure;
+    explicit progressive_save(pyobject render) : _render{std::move(render)} {}
+
+    void _finish() noexcept {
+        if (_render) {
+            try { wait(); } catch (...) {}
+        }
+    }
+
+    pyobject _render;
+};
+
 //! Wrapper around a matplotlib.pyplot.Figure
 class figure : private detail::plt {
  public:
@@ -635,9 +1799,87 @@ class figure : private detail::plt {
         detail::pycall(_fig, "savefig", args(filename), kwargs(kw("bbox_inches") = "tight"));
     }
 
+    //! Write a low-resolution preview of this figure to `preview_filename` immediately, and render the full-quality
+    //! output to `filename` in a separate python process. The preview is the same render as the final output, only at
+    //! `preview_dpi`, and this call blocks until it has been written. Afterwards, the figure and the active rcParams
+    //! are pickled and handed over to the render process, so the figure can be modified or closed while the
+    //! full-quality output is rendered. Figures that cannot be pickled (e.g. with callbacks into C++) raise an error.
+    progressive_save save_progressive(const std::string& preview_filename,
+                                      const std::string& filename,
+                                      const progressive_save_options& opts = {}) const {
+        static const pyobject save = detail::define_pyfunction("save_progressive", R"(
+def save_progressive(fig, preview_filename, filename, preview_dpi, dpi):
+    import os, pickle, subprocess, sys, tempfile
+    import matplotlib
+
+    RENDER = """
+import os, pickle, sys
+import matplotlib
+matplotlib.use("Agg")
+state, filename, dpi = sys.argv[1], sys.argv[2], float(sys.argv[3])
+try:
+    with open(state, "rb") as f:
+        matplotlib.rcParams.update(pickle.load(f))
+        fig = pickle.load(f)
+finally:
+    os.remove(state)
+fig.savefig(filename, dpi=dpi if dpi > 0 else None, bbox_inches="tight")
+"""
+
+    class Render:
+        def __init__(self, process):
+            self.process = process
+
+        def ready(self):
+            return self.process.poll() is not None
+
+        def wait(self):
+            _, err = self.process.communicate()
+            if self.process.returncode == 0:
+                return None
+            lines = err.decode(errors="replace").strip().splitlines()
+            return lines[-1] if lines else f"render process exited with code {self.process.returncode}"
+
+    def interpreter():
+        # in embedded interpreters, sys.executable may not be the python installation we are running on
+        version = f"{sys.version_info.major}.{sys.version_info.minor}"
+        for candidate in (os.path.join(sys.base_exec_prefix, "bin", "python" + version),
+                          os.path.join(sys.base_exec_prefix, "python.exe")):
+            if os.path.isfile(candidate):
+                return candidate
+        return sys.executable
+
+    fig.savefig(preview_filename, dpi=preview_dpi, bbox_inches="tight")
+    with tempfile.NamedTemporaryFile(prefix="cpplot-", suffix=".pickle", delete=False) as state:
+        try:
+            pickle.dump({k: v for k, v in matplotlib.rcParams.items() if not k.startswith("backend")}, state)
+            pickle.dump(fig, state)
+        except BaseException:
+            state.close()
+            os.remove(state.name)
+            raise
+    try:
+        return Render(subprocess.Popen(
+            [interpreter(), "-c", RENDER, state.name, filename, str(dpi)],
+            stdin=subprocess.DEVNULL,
+            stdout=subprocess.DEVNULL,
+            stderr=subprocess.PIPE,
+            env=dict(os.environ, PYTHONPATH=os.pathsep.join(p for p in sys.path if p))
+        ))
+    except BaseException:
+        os.remove(state.name)
+        raise
+)");
+        return progressive_save{detail::pycall(save, args(_fig, preview_filename, filename, opts.preview_dpi, opts.dpi))};
+    }
+
     //! Close this figure
     void close() {
+        if (_is_closed)
+            return;
         detail::pycall(this->pyplot, "close", args(_id));
+        _is_closed = true;
+        detail::python::instance().notify_figure_closed();
     }
 
     //! Return the number of axis rows in this figure
@@ -666,7 +1908,7 @@ class figure : private detail::plt {
  private:
     //! Set the style to use (calls pyplot.style.use(style))
     void _set_style(const style& style) {
-        auto style_attr = pyobject::from(PyObject_GetAttrString(this->pyplot.get(), "style"));
+        auto style_attr = pyobject::from(detail::capi::get_attribute(this->pyplot.get(), "style"));
         if (style_attr)
             detail::pycall(style_attr, "use", args(std::string{style.name}));
         else if (style != default_style)
@@ -675,7 +1917,7 @@ class figure : private detail::plt {
 
     std::size_t _get_unused_id() const {
         std::size_t id = 0;
-        while (detail::pycall(this->pyplot, "fignum_exists", args(id)).get() == Py_True)
+        while (detail::from_pyobject<bool>(detail::pycall(this->pyplot, "fignum_exists", args(id))))
             ++id;
         return id;
     }
@@ -685,13 +1927,13 @@ class figure : private detail::plt {
         auto fig_ax_tuple = detail::pycall(this->pyplot, "subplots", no_args, kwargs);
         if (!fig_ax_tuple)
             throw exceptions::python_error("Could not create figure.");
-        if (!PySequence_Check(fig_ax_tuple.get()))
+        if (!detail::capi::is_sequence(fig_ax_tuple.get()))
             throw exceptions::python_error("Unexpected value returned from pyplot.subplots");
-        if (PySequence_Size(fig_ax_tuple.get()) != 2)
+        if (detail::capi::sequence_size(fig_ax_tuple.get()) != 2)
             throw exceptions::python_error("Unexpected value returned from pyplot.subplots");
         return {
-            pyobject{PySequence_GetItem(fig_ax_tuple.get(), 0)},
-            pyobject{PySequence_GetItem(fig_ax_tuple.get(), 1)}
+            pyobject{detail::capi::sequence_get(fig_ax_tuple.get(), 0)},
+            pyobject{detail::capi::sequence_get(fig_ax_tuple.get(), 1)}
         };
     }
 
@@ -699,9 +1941,59 @@ class figure : private detail::plt {
     grid _grid;
     pyobject _fig;
     std::vector<cpplot::axis> _axes;
+    bool _is_closed = false;
 };
 
 
+//! Writes figures as pages of a single PDF file. Each appended figure is written out immediately and closed
+//! afterwards, such that memory usage does not grow with the number of pages.
+class pdf_report {
+ public:
+    ~pdf_report() { close(); }
+
+    //! Create a report that is written to the file with the given name
+    explicit pdf_report(const std::string& filename) {
+        detail::pycontext{};
+        auto backend = pyobject::from(detail::capi::import_module("matplotlib.backends.backend_pdf"));
+        _pdf = detail::pycall(backend, "PdfPages", args(filename));
+        if (!_pdf)
+            throw exceptions::python_error("Could not create pdf report " + filename);
+    }
+
+    pdf_report(const pdf_report&) = delete;
+    pdf_report& operator=(const pdf_report&) = delete;
+
+    //! Add the given figure as a new page and close the figure
+    void append(figure& fig) {
+        if (!_pdf)
+            throw exceptions::exception("Cannot append to a closed pdf report");
+        detail::pycall(_pdf, "savefig", args(fig.get_pyobject()), kwargs(kw("bbox_inches") = "tight"));
+        fig.close();
+        ++_page_count;
+    }
+
+    //! Add the given (temporary) figure as a new page
+    void append(figure&& fig) {
+        append(fig);
+    }
+
+    //! Return the number of pages written so far
+    std::size_t page_count() const {
+        return _page_count;
+    }
+
+    //! Finalize the pdf file (called automatically on destruction)
+    void close() {
+        if (_pdf)
+            detail::pycall(_pdf, "close");
+        _pdf = pyobject{};
+    }
+
+ private:
+    pyobject _pdf;
+    std::size_t _page_count = 0;
+};
+
 // default trait implementations
 namespace traits {
 
@@ -709,28 +2001,57 @@ template<std::ranges::range R>
 struct to_pyobject<R> {
     static PyObject* from(const R& range) {
         detail::pycontext{};
-        auto list = PyList_New(std::ranges::size(range));
-        std::ranges::for_each(range, [&, i=0] (const auto& value) mutable {
-            PyList_SetItem(list, i++, detail::to_pyobject(value).release());
-        });
-        return list;
+        auto list = pyobject::from(detail::capi::new_list(std::ranges::size(range)));
+        if (!list)
+            return nullptr;
+        std::size_t i = 0;
+        for (const auto& value : range) {
+            auto item = detail::to_pyobject(value);
+            if (!item)
+                return nullptr;
+            detail::capi::list_set(list.get(), i++, item.release());
+        }
+        return list.release();
     }
 };
 
+
 template<concepts::as_image T>
     requires(!concepts::range_2d<T>)  // because in that case the range specialization is taken
 struct to_pyobject<T> {
     static PyObject* from(const T& img) {
         detail::pycontext{};
         const auto grid = image_size<T>::get(img);
-        auto py_image = PyList_New(grid.rows);
+        auto py_image = pyobject::from(detail::capi::new_list(grid.rows));
+        if (!py_image)
+            return nullptr;
         for (std::size_t row = 0; row < grid.rows; ++row) {
-            auto py_row = PyList_New(grid.cols);
-            for (std::size_t col = 0; col < grid.cols; ++col)
-                PyList_SetItem(py_row, col, detail::to_pyobject(image_access<T>::at({.row = row, .col = col}, img)).release());
-            PyList_SetItem(py_image, row, py_row);
+            auto py_row = pyobject::from(detail::capi::new_list(grid.cols));
+            if (!py_row)
+                return nullptr;
+            for (std::size_t col = 0; col < grid.cols; ++col) {
+                auto value = detail::to_pyobject(image_access<T>::at({.row = row, .col = col}, img));
+                if (!value)
+                    return nullptr;
+                detail::capi::list_set(py_row.get(), col, value.release());
+            }
+            detail::capi::list_set(py_image.get(), row, py_row.release());
         }
-        return py_image;
+        return py_image.release();
+    }
+};
+
+template<std::floating_point T>
+struct to_pyobject<persistent_buffer<T>> {
+    static PyObject* from(const persistent_buffer<T>& buffer) {
+        return pyobject{buffer.array()}.release();
+    }
+};
+
+template<typename F>
+struct to_pyobject<py_callback<F>> {
+    static PyObject* from(const py_callback<F>& callback) {
+        return detail::make_pycallable_from(callback.function).release();
     }
 };
 
@@ -748,3 +2069,7 @@ struct point_access<R, dimension> {
 }  // namespace traits
 
 }  // namespace cpplot
+
+#ifndef CPPLOT_COMPILED_LIB
+    #include "cpplot-inl.hpp"
+#endif
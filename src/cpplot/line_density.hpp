@@ -0,0 +1,88 @@
+// SPDX-FileCopyrightText: 2024 Dennis Gläser <dennis.a.glaeser@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Density images of large numbers of lines, rasterized in C++ (see `axis::line_density`).
+
+#pragma once
+
+#include "cpplot.hpp"
+
+namespace cpplot {
+
+#ifndef DOXYGEN
+namespace detail {
+
+    template<typename Dependent>
+    inline constexpr bool has_header<line_density_header, Dependent> = true;
+
+}  // namespace detail
+#endif  // DOXYGEN
+
+template<typename L, typename... K>
+pyobject axis::_line_density(L&& lines, const py_kwargs<K...>& kwargs, const line_density_options& opts) {
+    using point = std::ranges::range_value_t<std::ranges::range_value_t<L>>;
+    const auto x_of = [] (const point& p) { return static_cast<double>(traits::point_access<point, 0>::get(p)); };
+    const auto y_of = [] (const point& p) { return static_cast<double>(traits::point_access<point, 1>::get(p)); };
+    const std::size_t line_count = std::ranges::size(lines);
+    const std::size_t chunk_count = std::min<std::size_t>(detail::hardware_threads(), line_count);
+
+    auto x_limits = detail::get_fixed_limits(_ax, "x");
+    auto y_limits = detail::get_fixed_limits(_ax, "y");
+    if (!std::isfinite(x_limits[0]) || !std::isfinite(y_limits[0])) {
+        std::vector<std::array<double, 4>> boxes(chunk_count, {
+            std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest(),
+            std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest()
+        });
+        detail::parallel_for(chunk_count, [&] (std::size_t chunk) {
+            for (std::size_t i = chunk*line_count/chunk_count; i < (chunk + 1)*line_count/chunk_count; ++i)
+                for (const auto& p : lines[i])
+                    if (std::isfinite(x_of(p)) && std::isfinite(y_of(p)))
+                        boxes[chunk] = {
+                            std::min(boxes[chunk][0], x_of(p)), std::max(boxes[chunk][1], x_of(p)),
+                            std::min(boxes[chunk][2], y_of(p)), std::max(boxes[chunk][3], y_of(p))
+                        };
+        });
+        std::array<double, 4> box = boxes.empty() ? std::array<double, 4>{0.0, 1.0, 0.0, 1.0} : boxes[0];
+        for (const auto& b : boxes)
+            box = {std::min(box[0], b[0]), std::max(box[1], b[1]), std::min(box[2], b[2]), std::max(box[3], b[3])};
+        if (!std::isfinite(x_limits[0])) x_limits = {box[0], box[1]};
+        if (!std::isfinite(y_limits[0])) y_limits = {box[2], box[3]};
+    }
+    for (auto* limits : {&x_limits, &y_limits})
+        if (!((*limits)[1] > (*limits)[0]))
+            *limits = {(*limits)[0] - 0.5, (*limits)[0] + 0.5};
+
+    const grid size = opts.resolution;
+    const double sx = static_cast<double>(size.cols)/(x_limits[1] - x_limits[0]);
+    const double sy = static_cast<double>(size.rows)/(y_limits[1] - y_limits[0]);
+    std::vector<std::vector<float>> partial_images(chunk_count);
+    detail::parallel_for(chunk_count, [&] (std::size_t chunk) {
+        auto& image = partial_images[chunk];
+        image.assign(size.rows*size.cols, 0.0f);
+        for (std::size_t i = chunk*line_count/chunk_count; i < (chunk + 1)*line_count/chunk_count; ++i) {
+            std::optional<std::array<double, 2>> previous;
+            for (const auto& p : lines[i]) {
+                const std::array<double, 2> current{(x_of(p) - x_limits[0])*sx - 0.5, (y_of(p) - y_limits[0])*sy - 0.5};
+                if (previous)
+                    detail::accumulate_segment(image, size, (*previous)[0], (*previous)[1], current[0], current[1]);
+                previous = current;
+            }
+        }
+    });
+
+    detail::pybuffer<float> image{size.rows*size.cols};
+    const auto values = image.values();
+    detail::parallel_for(values.size(), [&] (std::size_t i) {
+        values[i] = 0.0f;
+        for (const auto& partial : partial_images)
+            values[i] += partial[i];
+    }, 4096);
+    return _imshow(image.array({size.rows, size.cols}), detail::merge(cpplot::kwargs(
+        kw("extent") = std::array<double, 4>{x_limits[0], x_limits[1], y_limits[0], y_limits[1]},
+        kw("origin") = "lower",
+        kw("aspect") = "auto",
+        kw("interpolation") = "nearest"
+    ), kwargs), {.add_colorbar = opts.add_colorbar});
+}
+
+}  // namespace cpplot
@@ -0,0 +1,154 @@
+// SPDX-FileCopyrightText: 2024 Dennis Gläser <dennis.a.glaeser@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Level-of-detail series, which are plotted at screen resolution and refined on zoom (see `lod_series`).
+
+#pragma once
+
+#include "cpplot.hpp"
+
+namespace cpplot {
+
+//! A series of (x, y) values with a precomputed min/max pyramid, from which a representation of any x-window can be
+//! extracted at screen resolution. Lines plotted from it are updated whenever the x-limits of the axis change (e.g.
+//! on zoom/pan in interactive sessions), showing the visible window at full detail.
+class lod_series {
+ public:
+    //! Create a series from the given x- and y-values (x-values must be sorted in ascending order)
+    template<std::ranges::range X, std::ranges::range Y>
+        requires(concepts::scalar<std::ranges::range_value_t<X>> and concepts::scalar<std::ranges::range_value_t<Y>>)
+    lod_series(X&& x, Y&& y)
+    : _data{std::make_shared<data>(detail::to_double_vector(x), detail::to_double_vector(y))} {
+        if (_data->x.size() != _data->y.size())
+            throw exceptions::size_error("Number of x and y values do not match");
+        if (!std::ranges::is_sorted(_data->x))
+            throw exceptions::exception("x-values of a level-of-detail series must be sorted");
+        _build_pyramid();
+    }
+
+    //! Create a series from the given values, using the data point indices as x-values
+    template<std::ranges::sized_range Y>
+        requires(concepts::scalar<std::ranges::range_value_t<Y>>)
+    explicit lod_series(Y&& y)
+    : lod_series(std::views::iota(std::size_t{0}, std::ranges::size(y)), std::forward<Y>(y))
+    {}
+
+    //! Return the number of data points in this series
+    std::size_t size() const noexcept {
+        return _data->x.size();
+    }
+
+    //! Return the range of x-values in this series
+    std::array<double, 2> x_range() const noexcept {
+        if (_data->x.empty())
+            return {0.0, 0.0};
+        return {_data->x.front(), _data->x.back()};
+    }
+
+    //! Return the points to be drawn for the window [x_min, x_max] at the given resolution (in pixels). Within each
+    //! pixel, at most the minimum and the maximum are kept, and one point beyond each side of the window is included.
+    std::pair<std::vector<double>, std::vector<double>> extract(double x_min, double x_max, std::size_t resolution) const {
+        std::pair<std::vector<double>, std::vector<double>> result;
+        const auto& [x, y, levels] = *_data;
+        if (x.empty() || x_min > x_max)
+            return result;
+
+        const auto lower = std::ranges::lower_bound(x, x_min) - x.begin();
+        const auto upper = std::ranges::upper_bound(x, x_max) - x.begin();
+        const std::size_t first = static_cast<std::size_t>(std::max<std::ptrdiff_t>(lower - 1, 0));
+        const std::size_t last = std::min(static_cast<std::size_t>(upper), x.size() - 1);
+        const auto push = [&] (std::size_t i) {
+            result.first.push_back(x[i]);
+            result.second.push_back(y[i]);
+        };
+
+        std::size_t level = 0;
+        while (level < levels.size() && ((last - first + 1) >> level) > std::max(resolution, std::size_t{1}))
+            ++level;
+        if (level == 0) {
+            for (std::size_t i = first; i <= last; ++i)
+                push(i);
+            return result;
+        }
+
+        const auto& blocks = levels[level - 1];
+        std::size_t last_pushed = first;
+        push(first);
+        for (std::size_t block = first >> level; block <= std::min(last >> level, blocks.size() - 1); ++block) {
+            const auto [i_min, i_max] = std::minmax(blocks[block][0], blocks[block][1]);
+            for (std::size_t i : {i_min, i_max})
+                if (i > last_pushed && i < last) {
+                    push(i);
+                    last_pushed = i;
+                }
+        }
+        push(last);
+        return result;
+    }
+
+ private:
+    friend class axis;
+
+    struct data {
+        std::vector<double> x;
+        std::vector<double> y;
+        std::vector<std::vector<std::array<std::size_t, 2>>> levels;  // indices of min/max within blocks of 2^(l+1)
+    };
+
+    void _build_pyramid() {
+        auto& [x, y, levels] = *_data;
+        const auto merge = [&] (const std::array<std::size_t, 2>& a, const std::array<std::size_t, 2>& b) {
+            return std::array<std::size_t, 2>{
+                y[b[0]] < y[a[0]] ? b[0] : a[0],
+                y[b[1]] > y[a[1]] ? b[1] : a[1]
+            };
+        };
+
+        std::vector<std::array<std::size_t, 2>> current(y.size());
+        for (std::size_t i = 0; i < y.size(); ++i)
+            current[i] = {i, i};
+        while (current.size() > 1) {
+            std::vector<std::array<std::size_t, 2>> next((current.size() + 1)/2);
+            for (std::size_t i = 0; i < next.size(); ++i)
+                next[i] = 2*i + 1 < current.size() ? merge(current[2*i], current[2*i + 1]) : current[2*i];
+            levels.push_back(next);
+            current = std::move(next);
+        }
+    }
+
+    std::shared_ptr<data> _data;
+};
+
+#ifndef DOXYGEN
+namespace detail {
+
+    template<typename Dependent>
+    inline constexpr bool has_header<lod_header, Dependent> = true;
+
+}  // namespace detail
+#endif  // DOXYGEN
+
+template<typename... K>
+pyobject axis::_plot_lod_series(const lod_series& series, const py_kwargs<K...>& kwargs) {
+    const auto [x_min, x_max] = series.x_range();
+    const auto [x, y] = series.extract(x_min, x_max, _width_in_pixels());
+    auto lines = plot(x, y, kwargs);
+    if (!lines)
+        return lines;
+
+    auto line = pyobject::from(detail::capi::sequence_get(lines.get(), 0));
+    auto line_ref = pyobject::from(detail::capi::new_weak_reference(line.get()));  // avoid cycles via the axis' callbacks
+    auto on_limits_changed = callback([data = series, line_ref] (const pyobject& ax_object) {
+        pyobject line{detail::capi::weak_reference_target(line_ref.get())};
+        if (!line)
+            return pyobject{};
+        cpplot::axis ax{ax_object};
+        const auto [x_min, x_max] = detail::get_limits(ax._ax, "get_xlim");
+        const auto [x, y] = data.extract(std::min(x_min, x_max), std::max(x_min, x_max), ax._width_in_pixels());
+        return detail::pycall(line, "set_data", cpplot::args(x, y));
+    });
+    detail::pycall(detail::get_attribute(_ax, "callbacks"), "connect", args("xlim_changed", on_limits_changed));
+    return lines;
+}
+
+}  // namespace cpplot
@@ -0,0 +1,137 @@
+// SPDX-FileCopyrightText: 2024 Dennis Gläser <dennis.a.glaeser@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Composition of many images into a single one, shown with one imshow call (see `axis::imshow_mosaic`).
+
+#pragma once
+
+#include "cpplot.hpp"
+
+namespace cpplot {
+
+#ifndef DOXYGEN
+namespace detail {
+
+    //! Return the number of rows and columns of the given image (for ragged ranges, the longest row counts)
+    template<concepts::image I>
+    grid image_shape(const I& img) {
+        if constexpr (concepts::as_image<I>)
+            return traits::image_size<I>::get(img);
+        else {
+            grid shape{.rows = 0, .cols = 0};
+            for (const auto& row : img) {
+                ++shape.rows;
+                shape.cols = std::max(shape.cols, static_cast<std::size_t>(std::ranges::distance(row)));
+            }
+            return shape;
+        }
+    }
+
+    //! Invoke `f(location, value)` for all pixels of the given image
+    template<concepts::image I, typename F>
+    void for_each_pixel(const I& img, F&& f) {
+        if constexpr (concepts::as_image<I>) {
+            const grid shape = traits::image_size<I>::get(img);
+            for (std::size_t row = 0; row < shape.rows; ++row)
+                for (std::size_t col = 0; col < shape.cols; ++col)
+                    f(grid_location{.row = row, .col = col}, traits::image_access<I>::at({.row = row, .col = col}, img));
+        } else {
+            std::size_t row = 0;
+            for (const auto& values : img) {
+                std::size_t col = 0;
+                for (const auto& value : values)
+                    f(grid_location{.row = row, .col = col++}, value);
+                ++row;
+            }
+        }
+    }
+
+    template<typename Dependent>
+    inline constexpr bool has_header<mosaic_header, Dependent> = true;
+
+}  // namespace detail
+#endif  // DOXYGEN
+
+template<typename R, typename... K>
+pyobject axis::_imshow_mosaic(R&& images, const py_kwargs<K...>& kwargs, const mosaic_options& opts) {
+    using tile_type = std::ranges::range_value_t<R>;
+    using tile_reference = std::ranges::range_reference_t<R&>;
+    std::vector<tile_type> owned_tiles;
+    std::vector<const tile_type*> tiles;
+    if constexpr (std::is_lvalue_reference_v<tile_reference>
+                  and std::same_as<std::remove_cvref_t<tile_reference>, tile_type>) {
+        for (const auto& img : images)
+            tiles.push_back(std::addressof(img));
+    } else {
+        // tiles produced on the fly (e.g. by a transform view) do not outlive the iteration, so we keep copies
+        for (auto&& img : images)
+            owned_tiles.emplace_back(std::forward<decltype(img)>(img));
+        for (const auto& img : owned_tiles)
+            tiles.push_back(std::addressof(img));
+    }
+    if (!opts.labels.empty() && opts.labels.size() != tiles.size())
+        throw exceptions::size_error("Number of labels and images do not match");
+
+    grid cell{.rows = 1, .cols = 1};
+    for (const auto* img : tiles) {
+        const grid shape = detail::image_shape(*img);
+        cell = {.rows = std::max(cell.rows, shape.rows), .cols = std::max(cell.cols, shape.cols)};
+    }
+    const std::size_t count = std::max(tiles.size(), std::size_t{1});
+    const std::size_t columns = opts.columns > 0 ? std::min(opts.columns, count) : static_cast<std::size_t>(
+        std::ceil(std::sqrt(static_cast<double>(count)))
+    );
+    const std::size_t rows = (count + columns - 1)/columns;
+    const grid atlas_shape{
+        .rows = rows*cell.rows + (rows - 1)*opts.padding,
+        .cols = columns*cell.cols + (columns - 1)*opts.padding
+    };
+    const auto origin = [&] (std::size_t tile) {
+        return grid_location{
+            .row = (tile/columns)*(cell.rows + opts.padding),
+            .col = (tile%columns)*(cell.cols + opts.padding)
+        };
+    };
+
+    detail::pybuffer<float> atlas{atlas_shape.rows*atlas_shape.cols};
+    const auto values = atlas.values();
+    std::ranges::fill(values, std::numeric_limits<float>::quiet_NaN());
+    detail::parallel_for(tiles.size(), [&] (std::size_t tile) {
+        double min = std::numeric_limits<double>::infinity();
+        double max = -std::numeric_limits<double>::infinity();
+        if (opts.normalize_tiles)
+            detail::for_each_pixel(*tiles[tile], [&] (const grid_location&, const auto& value) {
+                if (std::isfinite(static_cast<double>(value))) {
+                    min = std::min(min, static_cast<double>(value));
+                    max = std::max(max, static_cast<double>(value));
+                }
+            });
+        const double scale = max > min ? 1.0/(max - min) : 0.0;
+        const auto [row0, col0] = origin(tile);
+        detail::for_each_pixel(*tiles[tile], [&] (const grid_location& loc, const auto& value) {
+            const double v = opts.normalize_tiles ? (static_cast<double>(value) - min)*scale : static_cast<double>(value);
+            values[(row0 + loc.row)*atlas_shape.cols + col0 + loc.col] = static_cast<float>(v);
+        });
+    });
+
+    auto image = _imshow(atlas.array({atlas_shape.rows, atlas_shape.cols}), detail::merge(cpplot::kwargs(
+        kw("interpolation") = "nearest"
+    ), kwargs), {.add_colorbar = opts.add_colorbar});
+    if (!opts.labels.empty()) {
+        std::vector<std::array<double, 2>> positions(tiles.size());
+        for (std::size_t tile = 0; tile < tiles.size(); ++tile)
+            positions[tile] = {
+                static_cast<double>(origin(tile).col) - 0.5,
+                static_cast<double>(origin(tile).row) - 0.5
+            };
+        annotate_many(positions, opts.labels, cpplot::kwargs(
+            kw("va") = "top",
+            kw("ha") = "left",
+            kw("fontsize") = "x-small",
+            kw("color") = "white"
+        ));
+    }
+    return image;
+}
+
+}  // namespace cpplot
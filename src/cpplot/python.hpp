@@ -0,0 +1,22 @@
+// SPDX-FileCopyrightText: 2024 Dennis Gläser <dennis.a.glaeser@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Access to the python C API, e.g. for implementing traits::to_pyobject or for working with the objects returned by
+// cpplot. cpplot.hpp only forward-declares PyObject and includes this header only in header-only mode, such that
+// users of the cpplot_core library (CPPLOT_COMPILED_LIB) have to include it where they use the C API.
+
+#pragma once
+
+#ifdef CPPLOT_DISABLE_PYTHON_DEBUG_BUILD
+    #ifdef _DEBUG
+        #undef _DEBUG
+        #include <Python.h>
+        #define _DEBUG
+    #else
+        #include <Python.h>
+    #endif
+#else
+    #include <Python.h>
+#endif
+
+#include "cpplot.hpp"
@@ -0,0 +1,118 @@
+// SPDX-FileCopyrightText: 2024 Dennis Gläser <dennis.a.glaeser@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Spectrograms of real-valued signals, computed from windowed FFTs in C++ (see `axis::spectrogram`).
+
+#pragma once
+
+#include <bit>
+#include <numbers>
+#include <numeric>
+
+#include "cpplot.hpp"
+#include "complex.hpp"
+
+namespace cpplot {
+
+#ifndef DOXYGEN
+namespace detail {
+
+    //! Precomputed bit-reversal permutation and twiddle factors for radix-2 FFTs of a fixed size (a power of two)
+    class fft_plan {
+     public:
+        explicit fft_plan(std::size_t size)
+        : _permutation(size)
+        , _twiddles(size/2) {
+            if (size == 0 || (size & (size - 1)) != 0)
+                throw exceptions::size_error("FFT size must be a power of two");
+            for (std::size_t i = 0, j = 0; i < size; ++i) {
+                _permutation[i] = j;
+                for (std::size_t bit = size >> 1; bit > 0 && ((j ^= bit) & bit) == 0; bit >>= 1) {}
+            }
+            for (std::size_t k = 0; k < size/2; ++k)
+                _twiddles[k] = std::polar(1.0, -2.0*std::numbers::pi*static_cast<double>(k)/static_cast<double>(size));
+        }
+
+        std::size_t size() const noexcept {
+            return _permutation.size();
+        }
+
+        //! Transform the given data (of the size of this plan) in place
+        void operator()(std::span<std::complex<double>> data) const {
+            const std::size_t n = size();
+            for (std::size_t i = 0; i < n; ++i)
+                if (i < _permutation[i])
+                    std::swap(data[i], data[_permutation[i]]);
+            for (std::size_t length = 2; length <= n; length <<= 1) {
+                const std::size_t half = length/2;
+                const std::size_t stride = n/length;
+                for (std::size_t start = 0; start < n; start += length)
+                    for (std::size_t k = 0; k < half; ++k) {
+                        const auto t = _twiddles[k*stride]*data[start + k + half];
+                        data[start + k + half] = data[start + k] - t;
+                        data[start + k] += t;
+                    }
+            }
+        }
+
+     private:
+        std::vector<std::size_t> _permutation;
+        std::vector<std::complex<double>> _twiddles;
+    };
+
+    template<typename Dependent>
+    inline constexpr bool has_header<spectrogram_header, Dependent> = true;
+
+}  // namespace detail
+#endif  // DOXYGEN
+
+template<typename R, typename... K>
+pyobject axis::_spectrogram(R&& signal,
+                            double sample_rate,
+                            const py_kwargs<K...>& kwargs,
+                            const spectrogram_options& opts) {
+    if (opts.frame_size == 0 || opts.overlap >= opts.frame_size)
+        throw exceptions::size_error("Frame size must be positive and larger than the overlap");
+    if (!(sample_rate > 0.0))
+        throw exceptions::exception("Sample rate must be positive");
+
+    const auto samples = detail::to_double_vector(signal);
+    const std::size_t hop = opts.frame_size - opts.overlap;
+    const std::size_t frames = samples.size() > opts.frame_size ? 1 + (samples.size() - opts.frame_size)/hop : 1;
+    const detail::fft_plan fft{std::bit_ceil(opts.frame_size)};
+    const std::size_t bins = fft.size()/2 + 1;
+    const auto window = detail::window_coefficients(opts.window, opts.frame_size);
+    const double window_power = std::transform_reduce(window.begin(), window.end(), 0.0, std::plus{}, [] (double w) {
+        return w*w;
+    });
+
+    detail::pybuffer<float> image{bins*frames};
+    const auto values = image.values();
+    detail::parallel_for(frames, [&] (std::size_t frame) {
+        thread_local std::vector<std::complex<double>> data;
+        data.assign(fft.size(), 0.0);
+        for (std::size_t i = 0; i < opts.frame_size && frame*hop + i < samples.size(); ++i)
+            data[i] = samples[frame*hop + i]*window[i];
+        fft(data);
+        for (std::size_t bin = 0; bin < bins; ++bin) {
+            const bool is_edge = bin == 0 || 2*bin == fft.size();  // one-sided spectrum: double all other bins
+            const double density = std::norm(data[bin])*(is_edge ? 1.0 : 2.0)/(sample_rate*window_power);
+            values[bin*frames + frame] = static_cast<float>(opts.decibels ? 10.0*std::log10(density) : density);
+        }
+    });
+
+    const double dt = static_cast<double>(hop)/sample_rate;
+    const double df = sample_rate/static_cast<double>(fft.size());
+    const double t_first = 0.5*static_cast<double>(opts.frame_size)/sample_rate;
+    return _imshow(image.array({bins, frames}), detail::merge(cpplot::kwargs(
+        kw("extent") = std::array<double, 4>{
+            t_first - 0.5*dt, t_first + (static_cast<double>(frames) - 0.5)*dt,
+            -0.5*df, (static_cast<double>(bins) - 0.5)*df
+        },
+        kw("origin") = "lower",
+        kw("aspect") = "auto",
+        kw("interpolation") = "nearest"
+    ), kwargs), {.add_colorbar = opts.add_colorbar});
+}
+
+}  // namespace cpplot
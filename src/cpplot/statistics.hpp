@@ -0,0 +1,511 @@
+// SPDX-FileCopyrightText: 2024 Dennis Gläser <dennis.a.glaeser@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Streaming statistics (quantile sketches, running moments and series of them over time buckets) and the axis
+// functions plotting them (see `axis::ecdf`, `axis::plot_quantile_band` and `axis::plot_mean_band`).
+
+#pragma once
+
+#include <map>
+#include <list>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+
+#include "cpplot.hpp"
+
+namespace cpplot {
+
+//! Mergeable sketch of a stream of values, from which approximate quantiles can be queried (KLL sketch). The number
+//! of retained values grows only logarithmically with the number of inserted values, with k controlling the accuracy.
+class quantile_sketch {
+ public:
+    explicit quantile_sketch(std::size_t k = 200)
+    : _k{std::max(k, std::size_t{8})}
+    , _levels(1) {
+        _update_capacities();
+    }
+
+    //! Insert a value into the sketch (NaNs are ignored)
+    void insert(double value) {
+        if (std::isnan(value))
+            return;
+        _levels[0].push_back(value);
+        ++_count;
+        if (_levels[0].size() >= _capacities[0])
+            _compress();
+    }
+
+    //! Merge the values of the given sketch into this one (e.g. to combine sketches filled on different threads)
+    void merge(const quantile_sketch& other) {
+        if (_levels.size() < other._levels.size()) {
+            _levels.resize(other._levels.size());
+            _update_capacities();
+        }
+        for (std::size_t level = 0; level < other._levels.size(); ++level)
+            _levels[level].insert(_levels[level].end(), other._levels[level].begin(), other._levels[level].end());
+        _count += other._count;
+        _compress();
+    }
+
+    //! Return the number of values inserted into this sketch
+    std::size_t count() const noexcept {
+        return _count;
+    }
+
+    //! Return the approximate quantile for the given probability (NaN if the sketch is empty)
+    double quantile(double p) const {
+        return quantiles(std::array{p})[0];
+    }
+
+    //! Return the approximate quantiles for the given probabilities (NaN if the sketch is empty)
+    std::vector<double> quantiles(std::span<const double> probabilities) const {
+        std::vector<std::pair<double, std::size_t>> items;
+        for (std::size_t level = 0; level < _levels.size(); ++level)
+            for (double value : _levels[level])
+                items.emplace_back(value, std::size_t{1} << level);
+        std::ranges::sort(items);
+
+        std::vector<double> cumulative_weights(items.size());
+        std::size_t weight = 0;
+        for (std::size_t i = 0; i < items.size(); ++i)
+            cumulative_weights[i] = static_cast<double>(weight += items[i].second);
+
+        std::vector<double> result;
+        result.reserve(probabilities.size());
+        for (double p : probabilities) {
+            if (items.empty()) {
+                result.push_back(std::numeric_limits<double>::quiet_NaN());
+                continue;
+            }
+            const double target = std::clamp(p, 0.0, 1.0)*static_cast<double>(weight);
+            const auto it = std::ranges::lower_bound(cumulative_weights, target);
+            const auto i = std::min(static_cast<std::size_t>(it - cumulative_weights.begin()), items.size() - 1);
+            result.push_back(items[i].first);
+        }
+        return result;
+    }
+
+ private:
+    void _update_capacities() {
+        _capacities.resize(_levels.size());
+        for (std::size_t level = 0; level < _levels.size(); ++level)
+            _capacities[level] = std::max(static_cast<std::size_t>(std::ceil(
+                static_cast<double>(_k)*std::pow(2.0/3.0, static_cast<double>(_levels.size() - level - 1))
+            )), std::size_t{2});
+    }
+
+    // Compact full levels by sorting them and promoting every other value (with random offset) to the next level,
+    // where it represents twice the weight. For odd sizes, one value stays behind to preserve the total weight.
+    void _compress() {
+        for (std::size_t level = 0; level < _levels.size(); ++level) {
+            if (_levels[level].size() < _capacities[level])
+                continue;
+            if (level + 1 == _levels.size()) {
+                _levels.emplace_back();
+                _update_capacities();
+            }
+            auto& values = _levels[level];
+            std::ranges::sort(values);
+            std::optional<double> remainder;
+            if (values.size() % 2 == 1) {
+                remainder = values.back();
+                values.pop_back();
+            }
+            for (std::size_t i = _random_bit(); i < values.size(); i += 2)
+                _levels[level + 1].push_back(values[i]);
+            values.clear();
+            if (remainder)
+                values.push_back(*remainder);
+        }
+    }
+
+    std::size_t _random_bit() noexcept {
+        _random_state ^= _random_state << 13;
+        _random_state ^= _random_state >> 7;
+        _random_state ^= _random_state << 17;
+        return static_cast<std::size_t>(_random_state & 1);
+    }
+
+    std::size_t _k;
+    std::size_t _count = 0;
+    std::vector<std::vector<double>> _levels;
+    std::vector<std::size_t> _capacities;
+    std::uint64_t _random_state = 0x9E3779B97F4A7C15ull;
+};
+
+//! Running count, mean and variance of a stream of values (Welford's algorithm). Instances can be merged, e.g. to
+//! combine the results of different threads.
+class running_moments {
+ public:
+    //! Insert a value (NaNs are ignored)
+    void insert(double value) noexcept {
+        if (std::isnan(value))
+            return;
+        ++_count;
+        const double delta = value - _mean;
+        _mean += delta/static_cast<double>(_count);
+        _m2 += delta*(value - _mean);
+    }
+
+    //! Merge the values of the given instance into this one
+    void merge(const running_moments& other) noexcept {
+        if (other._count == 0)
+            return;
+        const double count = static_cast<double>(_count + other._count);
+        const double delta = other._mean - _mean;
+        _mean += delta*static_cast<double>(other._count)/count;
+        _m2 += other._m2 + delta*delta*static_cast<double>(_count)*static_cast<double>(other._count)/count;
+        _count += other._count;
+    }
+
+    //! Return the number of inserted values
+    std::size_t count() const noexcept {
+        return _count;
+    }
+
+    //! Return the mean of the inserted values (NaN if empty)
+    double mean() const noexcept {
+        return _count > 0 ? _mean : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    //! Return the sample variance of the inserted values (NaN for less than two values)
+    double variance() const noexcept {
+        return _count > 1 ? _m2/static_cast<double>(_count - 1) : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    //! Return the sample standard deviation of the inserted values (NaN for less than two values)
+    double standard_deviation() const noexcept {
+        return std::sqrt(variance());
+    }
+
+ private:
+    std::size_t _count = 0;
+    double _mean = 0.0;
+    double _m2 = 0.0;
+};
+
+//! Series of accumulators (e.g. `quantile_sketch` or `running_moments`) for the buckets
+//! [start + i*bucket_width, start + (i+1)*bucket_width), which are created on demand. Only non-empty buckets are
+//! stored, so the memory usage is proportional to the number of buckets that received samples, independent of the
+//! number of samples and of gaps between them (e.g. due to outliers in the sample positions). Instances filled on
+//! different threads can be merged.
+template<typename A>
+class bucket_series {
+ public:
+    //! Create with the given buckets, each of which starts as a copy of the given empty accumulator
+    bucket_series(double start, double bucket_width, A empty = A{})
+    : _start{start}
+    , _bucket_width{bucket_width}
+    , _empty{std::move(empty)} {
+        if (!(bucket_width > 0.0))
+            throw exceptions::exception("Bucket width must be positive");
+    }
+
+    //! Maximum number of buckets, which keeps bucket indices exactly representable as floating-point values
+    static constexpr std::size_t max_bucket_count = std::size_t{1} << 53;
+
+    //! Insert a sample at the given position (samples before the start or at non-finite positions are ignored).
+    //! Throws if the position lies beyond the last of the `max_bucket_count` buckets.
+    void insert(double x, double value) {
+        if (!std::isfinite(x) || !(x >= _start))
+            return;
+        const double index = std::floor((x - _start)/_bucket_width);
+        if (!(index < static_cast<double>(max_bucket_count)))
+            throw exceptions::size_error("Sample position exceeds the maximum number of buckets");
+        _bucket(static_cast<std::size_t>(index)).insert(value);
+    }
+
+    //! Merge the samples of the given instance, which must use the same buckets, into this one
+    void merge(const bucket_series& other) {
+        if (other._start != _start || other._bucket_width != _bucket_width)
+            throw exceptions::exception("Cannot merge bucket series with different buckets");
+        for (const auto& [i, accumulator] : other._buckets)
+            _bucket(i).merge(accumulator);
+    }
+
+    //! Return the number of buckets up to (and including) the last non-empty one
+    std::size_t bucket_count() const noexcept {
+        return _buckets.empty() ? 0 : _buckets.rbegin()->first + 1;
+    }
+
+    //! Return the position at the center of the i-th bucket
+    double bucket_center(std::size_t i) const noexcept {
+        return _start + (static_cast<double>(i) + 0.5)*_bucket_width;
+    }
+
+    //! Return the accumulator of the i-th bucket (the empty accumulator for buckets without samples)
+    const A& operator[](std::size_t i) const {
+        const auto it = _buckets.find(i);
+        return it != _buckets.end() ? it->second : _empty;
+    }
+
+    //! Return the non-empty buckets, ordered by their index
+    const std::map<std::size_t, A>& buckets() const noexcept {
+        return _buckets;
+    }
+
+    //! Remove all samples
+    void clear() noexcept {
+        _buckets.clear();
+    }
+
+ private:
+    A& _bucket(std::size_t i) {
+        return _buckets.try_emplace(i, _empty).first->second;
+    }
+
+    double _start;
+    double _bucket_width;
+    A _empty;
+    std::map<std::size_t, A> _buckets;
+};
+
+#ifndef DOXYGEN
+namespace detail {
+
+    //! Return the indices of the non-empty buckets of the given series, with the index of an (empty) bucket inserted
+    //! into each gap, such that plots of the bucket statistics are interrupted there (empty buckets yield NaN)
+    template<typename S>
+    std::vector<std::size_t> plotted_buckets(const S& series) {
+        std::vector<std::size_t> indices;
+        for (const auto& [i, _] : series.buckets()) {
+            if (!indices.empty() && i > indices.back() + 1)
+                indices.push_back(indices.back() + 1);
+            indices.push_back(i);
+        }
+        return indices;
+    }
+
+}  // namespace detail
+#endif  // DOXYGEN
+
+//! Approximate quantiles of a stream of (time, value) samples, kept as one `quantile_sketch` per time bucket
+class streaming_quantiles : public bucket_series<quantile_sketch> {
+ public:
+    //! Create with buckets [start + i*bucket_width, start + (i+1)*bucket_width) and the given accuracy of the sketches
+    streaming_quantiles(double start, double bucket_width, std::size_t k = 200)
+    : bucket_series{start, bucket_width, quantile_sketch{k}}
+    {}
+};
+
+//! Mean and variance of a stream of (x, value) samples, e.g. repeated measurements, kept as one `running_moments`
+//! per x-bucket. Samples can be inserted concurrently from any number of threads: each thread inserts into a shard
+//! of its own, and the shards are merged into the series whenever it is read (e.g. by `axis::plot_mean_band`).
+//! Reading, merging, copying and assigning must not happen concurrently with each other.
+class streaming_moments {
+    using series_type = bucket_series<running_moments>;
+
+ public:
+    static constexpr std::size_t max_bucket_count = series_type::max_bucket_count;
+
+    //! Create with buckets [start + i*bucket_width, start + (i+1)*bucket_width)
+    streaming_moments(double start, double bucket_width)
+    : _series{start, bucket_width}
+    , _shards{std::make_unique<shards>(_series)}
+    {}
+
+    streaming_moments(const streaming_moments& other)
+    : _series{other.series()}
+    , _shards{std::make_unique<shards>(_series)}
+    {}
+
+    streaming_moments& operator=(const streaming_moments& other) {
+        if (this != &other) {
+            _series = other.series();
+            _shards = std::make_unique<shards>(_series);
+        }
+        return *this;
+    }
+
+    streaming_moments(streaming_moments&&) = default;
+    streaming_moments& operator=(streaming_moments&&) = default;
+
+    //! Insert a sample at the given position into the shard of the calling thread (thread-safe). Samples before the
+    //! start or at non-finite positions are ignored, positions beyond the last of the `max_bucket_count` buckets throw.
+    void insert(double x, double value) {
+        auto& shard = _local_shard();
+        std::scoped_lock lock{shard.mutex};
+        shard.series.insert(x, value);
+    }
+
+    //! Merge the samples of the given instance, which must use the same buckets, into this one
+    void merge(const streaming_moments& other) {
+        _collect();
+        _series.merge(other.series());
+    }
+
+    //! Return all samples inserted so far (from all threads) as a single series
+    const series_type& series() const {
+        _collect();
+        return _series;
+    }
+
+    //! Return the number of buckets up to (and including) the last non-empty one
+    std::size_t bucket_count() const { return series().bucket_count(); }
+
+    //! Return the position at the center of the i-th bucket
+    double bucket_center(std::size_t i) const noexcept { return _series.bucket_center(i); }
+
+    //! Return the moments of the i-th bucket
+    const running_moments& operator[](std::size_t i) const { return series()[i]; }
+
+    //! Return the non-empty buckets, ordered by their index
+    const std::map<std::size_t, running_moments>& buckets() const { return series().buckets(); }
+
+ private:
+    struct shard {
+        explicit shard(const series_type& empty) : series{empty} {}
+        std::mutex mutex;
+        series_type series;
+    };
+
+    struct shards {
+        explicit shards(const series_type& prototype) : empty{prototype} { empty.clear(); }
+        std::uint64_t id = _next_id();
+        std::mutex mutex;
+        series_type empty;
+        std::list<shard> list;  // stable addresses, which are cached by the inserting threads
+    };
+
+    static std::uint64_t _next_id() {
+        static std::atomic<std::uint64_t> next{0};
+        return next++;
+    }
+
+    shard& _local_shard() {
+        // the ids are never reused, so entries of destroyed instances are never accessed again
+        thread_local std::unordered_map<std::uint64_t, shard*> local_shards;
+        auto& cached = local_shards[_shards->id];
+        if (!cached) {
+            std::scoped_lock lock{_shards->mutex};
+            cached = &_shards->list.emplace_back(_shards->empty);
+        }
+        return *cached;
+    }
+
+    void _collect() const {
+        if (!_shards)
+            return;
+        std::scoped_lock lock{_shards->mutex};
+        for (auto& shard : _shards->list) {
+            std::scoped_lock shard_lock{shard.mutex};
+            _series.merge(shard.series);
+            shard.series.clear();
+        }
+    }
+
+    mutable series_type _series;
+    std::unique_ptr<shards> _shards;
+};
+
+#ifndef DOXYGEN
+namespace detail {
+
+    template<typename Dependent>
+    inline constexpr bool has_header<statistics_header, Dependent> = true;
+
+}  // namespace detail
+#endif  // DOXYGEN
+
+template<typename R, typename... K>
+pyobject axis::_ecdf(R&& values, const py_kwargs<K...>& kwargs, const ecdf_options& opts) {
+    std::vector<double> samples;
+    samples.reserve(std::ranges::size(values));
+    for (const auto& v : values)
+        if (!std::isnan(static_cast<double>(v)))
+            samples.push_back(static_cast<double>(v));
+    const std::size_t n = samples.size();
+    if (n == 0)
+        return plot(std::vector<double>{}, std::vector<double>{}, kwargs);
+
+    const std::size_t points = std::max<std::size_t>(opts.points > 0 ? opts.points : static_cast<std::size_t>(
+        detail::get_size_in_pixels(_ax)[1]
+    ), 2);
+    std::vector<std::size_t> ranks;
+    const auto add_rank = [&] (double p) {
+        ranks.push_back(std::min(static_cast<std::size_t>(std::max(std::ceil(p*static_cast<double>(n)), 1.0)) - 1, n - 1));
+    };
+    for (std::size_t i = 0; i < points; ++i)
+        add_rank(static_cast<double>(i)/static_cast<double>(points - 1));
+    if (opts.tail_points_per_decade > 0) {
+        const auto tail_points = static_cast<std::size_t>(
+            std::max(std::log10(static_cast<double>(n)) - 1.0, 0.0)*static_cast<double>(opts.tail_points_per_decade)
+        );
+        for (std::size_t i = 0; i <= tail_points; ++i)
+            add_rank(1.0 - std::pow(10.0, -1.0 - static_cast<double>(i)/static_cast<double>(opts.tail_points_per_decade)));
+    }
+    std::ranges::sort(ranks);
+    ranks.erase(std::ranges::unique(ranks).begin(), ranks.end());
+
+    const auto levels = static_cast<unsigned>(std::ceil(std::log2(detail::hardware_threads())));
+    detail::multi_select(samples, ranks, 0, levels);
+
+    std::vector<double> x(ranks.size());
+    std::vector<double> p(ranks.size());
+    std::ranges::transform(ranks, x.begin(), [&] (std::size_t rank) { return samples[rank]; });
+    std::ranges::transform(ranks, p.begin(), [&] (std::size_t rank) {
+        return opts.complementary ? 1.0 - static_cast<double>(rank)/static_cast<double>(n)
+                                  : static_cast<double>(rank + 1)/static_cast<double>(n);
+    });
+    return plot(x, p, kwargs);
+}
+
+template<typename... K>
+pyobject axis::_plot_quantile_band(const streaming_quantiles& quantiles,
+                                   const py_kwargs<K...>& kwargs,
+                                   const quantile_band_options& opts) {
+    static const pyobject plot_band = detail::define_pyfunction("plot_quantile_band", R"(
+def plot_quantile_band(ax, t, values, alpha, **kwargs):
+    lines = ax.plot(t, values[0], **kwargs)
+    kwargs["color"] = lines[0].get_color()
+    for v in values[1:]:
+        lines.extend(ax.plot(t, v, **kwargs))
+    for lower, upper in zip(values, values[1:]):
+        ax.fill_between(t, lower, upper, color=kwargs["color"], alpha=alpha, linewidth=0)
+    return lines
+)");
+    if (opts.quantiles.empty())
+        throw exceptions::exception("At least one quantile is required");
+
+    std::vector<double> probabilities = opts.quantiles;
+    std::ranges::sort(probabilities);
+    const auto buckets = detail::plotted_buckets(quantiles);
+    std::vector<double> t(buckets.size());
+    std::vector<std::vector<double>> values(probabilities.size(), std::vector<double>(t.size()));
+    detail::parallel_for(t.size(), [&] (std::size_t i) {
+        t[i] = quantiles.bucket_center(buckets[i]);
+        const auto bucket_values = quantiles[buckets[i]].quantiles(probabilities);
+        for (std::size_t q = 0; q < probabilities.size(); ++q)
+            values[q][i] = bucket_values[q];
+    });
+    return detail::pycall(plot_band, args(_ax, t, values, opts.band_alpha), kwargs);
+}
+
+template<typename... K>
+pyobject axis::_plot_mean_band(const streaming_moments& moments,
+                               const py_kwargs<K...>& kwargs,
+                               const mean_band_options& opts) {
+    static const pyobject plot_band = detail::define_pyfunction("plot_mean_band", R"(
+def plot_mean_band(ax, x, mean, lower, upper, alpha, **kwargs):
+    lines = ax.plot(x, mean, **kwargs)
+    ax.fill_between(x, lower, upper, color=lines[0].get_color(), alpha=alpha, linewidth=0)
+    return lines
+)");
+    const auto& series = moments.series();  // merges the shards of all inserting threads
+    const auto buckets = detail::plotted_buckets(series);
+    const std::size_t n = buckets.size();
+    std::vector<double> x(n), mean(n), lower(n), upper(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        const double deviation = opts.standard_deviations*series[buckets[i]].standard_deviation();
+        x[i] = series.bucket_center(buckets[i]);
+        mean[i] = series[buckets[i]].mean();
+        lower[i] = mean[i] - deviation;
+        upper[i] = mean[i] + deviation;
+    }
+    return detail::pycall(plot_band, args(_ax, x, mean, lower, upper, opts.band_alpha), kwargs);
+}
+
+}  // namespace cpplot
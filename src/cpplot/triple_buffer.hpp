@@ -0,0 +1,66 @@
+// SPDX-FileCopyrightText: 2024 Dennis Gläser <dennis.a.glaeser@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Lock-free handoff of frames between a producer and a rendering thread (see `triple_buffer`).
+
+#pragma once
+
+#include <atomic>
+
+#include "cpplot.hpp"
+
+namespace cpplot {
+
+//! Lock-free handoff of frames from a producer thread to a rendering thread (triple buffering). The producer writes
+//! a frame into the back buffer and publishes it, without ever waiting for the renderer (or python's GIL). The
+//! renderer picks up the most recently published frame (skipping frames published in between) and draws it from
+//! the front buffer, e.g. by copying it into a `persistent_buffer` and updating the artists. After publishing, the
+//! back buffer holds an older frame, which the producer has to overwrite.
+template<typename T>
+class triple_buffer {
+ public:
+    triple_buffer() = default;
+
+    //! Create with all three buffers initialized to the given value (e.g. to preallocate frame data)
+    explicit triple_buffer(const T& initial)
+    : _slots{initial, initial, initial}
+    {}
+
+    triple_buffer(const triple_buffer&) = delete;
+    triple_buffer& operator=(const triple_buffer&) = delete;
+
+    //! Return the buffer to write the next frame into (producer only)
+    T& back() noexcept {
+        return _slots[_back];
+    }
+
+    //! Publish the back buffer as the latest frame and continue with another buffer (producer only)
+    void publish() noexcept {
+        _back = _middle.exchange(_back | _fresh, std::memory_order_acq_rel) & _index;
+    }
+
+    //! Swap the most recently published frame into the front buffer, if one was published since the last call.
+    //! Returns true if the front buffer changed (renderer only).
+    bool update() noexcept {
+        if ((_middle.load(std::memory_order_relaxed) & _fresh) == 0)
+            return false;
+        _front = _middle.exchange(_front, std::memory_order_acq_rel) & _index;
+        return true;
+    }
+
+    //! Return the buffer holding the latest frame picked up by `update` (renderer only)
+    const T& front() const noexcept {
+        return _slots[_front];
+    }
+
+ private:
+    static constexpr std::size_t _index = 3;
+    static constexpr std::size_t _fresh = 4;
+
+    std::array<T, 3> _slots{};
+    std::size_t _back = 0;
+    std::size_t _front = 1;
+    std::atomic<std::size_t> _middle{2};
+};
+
+}  // namespace cpplot
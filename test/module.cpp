@@ -0,0 +1,40 @@
+// SPDX-FileCopyrightText: 2024 Dennis Gläser <dennis.a.glaeser@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#include <vector>
+#include <array>
+#include <filesystem>
+
+#include <boost/ut.hpp>
+
+import cpplot;
+
+using namespace boost::ut;
+
+int main() {
+    using namespace cpplot;
+    using namespace cpplot::literals;
+
+    "module_plot_and_save"_test = [] () {
+        figure fig;
+        fig.axis().plot(std::vector{1.0, 2.0, 3.0}, kwargs("color"_kw = "r"));
+        fig.axis().fill(std::vector<std::array<double, 2>>{{0, 0}, {1, 0}, {1, 1}});
+        fig.save_to("module_figure.png");
+        expect(std::filesystem::exists("module_figure.png"));
+    };
+
+    "module_memory_management"_test = [] () {
+        set_memory_policy({.collect_after_close = true});
+        expect(get_memory_policy().collect_after_close);
+        { figure fig; }
+        const memory_report report = trim_memory();
+        expect(report.python_blocks_after > 0);
+        set_memory_policy({});
+    };
+
+#ifdef Py_PYTHON_H
+    static_assert(false, "Python macros must not leak through the module");
+#endif
+
+    return 0;
+}
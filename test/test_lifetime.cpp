@@ -0,0 +1,239 @@
+// SPDX-FileCopyrightText: 2024 Dennis Gläser <dennis.a.glaeser@gmail.com>
+// SPDX-License-Identifier: MIT
+
+#include <string>
+#include <vector>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+#include <boost/ut.hpp>
+
+#include <cpplot/cpplot.hpp>
+#include <cpplot/line_density.hpp>
+#include <cpplot/lod.hpp>
+#include <cpplot/mosaic.hpp>
+#include <cpplot/python.hpp>
+#include <cpplot/spectrogram.hpp>
+#include <cpplot/statistics.hpp>
+
+using namespace boost::ut;
+
+//! Allocation state of the interpreter after clearing matplotlib's caches and a full garbage collection
+struct python_state {
+    std::size_t blocks;
+    std::size_t objects;
+};
+
+python_state get_python_state() {
+    static const cpplot::pyobject gc = cpplot::pyobject::from(PyImport_ImportModule("gc"));
+    const auto report = cpplot::trim_memory();
+    auto objects = cpplot::py_invoke(gc, "get_objects");
+    return {
+        .blocks = report.python_blocks_after,
+        .objects = static_cast<std::size_t>(PyList_Size(objects.get()))
+    };
+}
+
+//! Run the given action in a loop and return the growth of allocated blocks (or tracked objects) per iteration.
+//! Since matplotlib populates bounded caches (e.g. for fonts or text layouts) during the first few iterations, the
+//! loop is repeated a few times and the smallest growth is returned. A leak shows up in all repetitions.
+template<std::invocable F>
+double growth_per_iteration(F&& action, std::size_t iterations = 100, std::size_t repetitions = 3) {
+    for (int i = 0; i < 10; ++i)
+        action();
+
+    const auto growth = [&] (std::size_t b, std::size_t a) {
+        return a > b ? static_cast<double>(a - b)/static_cast<double>(iterations) : 0.0;
+    };
+
+    double result = std::numeric_limits<double>::max();
+    for (std::size_t repetition = 0; repetition < repetitions; ++repetition) {
+        const auto before = get_python_state();
+        for (std::size_t i = 0; i < iterations; ++i)
+            action();
+        const auto after = get_python_state();
+        result = std::min(result, std::max(growth(before.blocks, after.blocks), growth(before.objects, after.objects)));
+    }
+    return result;
+}
+
+// a leak of a single python object per iteration results in a growth of at least one block per iteration
+constexpr double tolerance = 0.5;
+
+int main() {
+    using namespace cpplot;
+    using namespace cpplot::literals;
+
+    "lifetime_pyobject_assignment"_test = [] () {
+        expect(lt(growth_per_iteration([] () {
+            pyobject obj = detail::to_pyobject(std::string(100, 'x'));
+            pyobject copy;
+            copy = obj;
+            copy = copy;
+            obj = std::move(copy);
+            const auto& self = obj;
+            obj = self;
+            expect(static_cast<bool>(obj) and PyUnicode_Check(obj.get()));
+        }), tolerance));
+    };
+
+    "lifetime_kwargs"_test = [] () {
+        static const pyobject dict = pyobject::from(PyObject_GetAttrString(PyImport_AddModule("builtins"), "dict"));
+        expect(lt(growth_per_iteration([] () {
+            auto result = py_invoke(dict, "__call__", no_args, kwargs(
+                "label"_kw = std::string(100, 'x'),
+                "values"_kw = std::vector<double>{1.5, 2.5, 3.5}
+            ));
+            expect(eq(PyDict_Size(result.get()), Py_ssize_t{2}));
+        }), tolerance));
+    };
+
+    "lifetime_range_conversion"_test = [] () {
+        expect(lt(growth_per_iteration([] () {
+            pyobject list{detail::to_pyobject(std::vector<std::vector<double>>(10, std::vector<double>(10, 1.5)))};
+            expect(eq(PyList_Size(list.get()), Py_ssize_t{10}));
+        }), tolerance));
+    };
+
+    "lifetime_figure"_test = [] () {
+        expect(lt(growth_per_iteration([] () {
+            figure fig;
+            fig.axis().plot(std::vector<double>{1.0, 2.0, 3.0}, kwargs("label"_kw = "values"));
+            fig.axis().set_x_label("x");
+        }, 30), tolerance));
+    };
+
+    "lifetime_figure_grid"_test = [] () {
+        expect(lt(growth_per_iteration([] () {
+            figure fig{{.rows = 2, .cols = 2}};
+            fig.axis_at({1, 1}).imshow(std::vector<std::vector<double>>(10, std::vector<double>(10, 1.0)));
+        }, 30), tolerance));
+    };
+
+    "lifetime_buffers"_test = [] () {
+        figure fig;
+        persistent_buffer<double> x{100}, y{100};
+        expect(lt(growth_per_iteration([&] () {
+            auto lines = fig.axis().plot(x, y);
+            py_invoke(pyobject{Py_XNewRef(PyList_GetItem(lines.get(), 0))}, "remove");
+            auto array = x.array();
+        }), tolerance));
+    };
+
+    "lifetime_imshow_mosaic"_test = [] () {
+        const std::vector<std::vector<std::vector<double>>> images(4, std::vector<std::vector<double>>(3, std::vector<double>(3, 1.0)));
+        expect(lt(growth_per_iteration([&] () {
+            figure fig;
+            fig.axis().imshow_mosaic(images, no_kwargs, {.labels = {"a", "b", "c", "d"}});
+        }, 30), tolerance));
+    };
+
+    "lifetime_callback"_test = [] () {
+        const std::vector<double> captured(100, 1.0);
+        expect(lt(growth_per_iteration([&] () {
+            // the capsule owning the function (and its captures) must be released with the callable
+            auto callable = detail::to_pyobject(callback([captured] (double x, const std::string& s) {
+                return captured[0]*x + static_cast<double>(s.size());
+            }));
+            auto result = py_invoke(callable, "__call__", args(2.0, std::string(100, 'x')));
+            expect(eq(detail::from_pyobject<double>(result), 102.0));
+        }), tolerance));
+    };
+
+    "lifetime_lod_series"_test = [] () {
+        std::vector<double> values(10000);
+        std::iota(values.begin(), values.end(), 0.0);
+        const lod_series series{values};
+        expect(lt(growth_per_iteration([&] () {
+            figure fig;
+            fig.axis().plot(series);
+            fig.axis().set_x_limits(100.0, 200.0);  // invokes the callback updating the line
+        }, 30), tolerance));
+    };
+
+    "lifetime_annotate_many"_test = [] () {
+        const std::vector<std::array<double, 2>> positions{{0.1, 0.1}, {0.1, 0.1}, {0.5, 0.5}, {5.0, 5.0}};
+        const std::vector<std::string> labels{"a", "b", "c", "d"};
+        expect(lt(growth_per_iteration([&] () {
+            figure fig;
+            fig.axis().set_x_limits(0.0, 1.0);
+            fig.axis().set_y_limits(0.0, 1.0);
+            fig.axis().annotate_many(positions, labels, kwargs("fontsize"_kw = 10), {.cull_overlaps = true});
+        }, 30), tolerance));
+    };
+
+    "lifetime_imshow_function"_test = [] () {
+        expect(lt(growth_per_iteration([] () {
+            figure fig;
+            fig.axis().imshow(grid{.rows = 20, .cols = 20}, [] (const grid_location& loc) {
+                return static_cast<double>(loc.row*loc.col);
+            });
+        }, 30), tolerance));
+    };
+
+    "lifetime_spectrogram_and_line_density"_test = [] () {
+        std::vector<double> signal(4096);
+        for (std::size_t i = 0; i < signal.size(); ++i)
+            signal[i] = std::sin(0.1*static_cast<double>(i));
+        std::vector<std::vector<std::array<double, 2>>> lines(20);
+        for (std::size_t i = 0; i < lines.size(); ++i)
+            for (int j = 0; j <= 10; ++j)
+                lines[i].push_back({j*0.1, static_cast<double>(i) + j*0.1});
+        expect(lt(growth_per_iteration([&] () {
+            figure fig{{.rows = 1, .cols = 2}};
+            fig.axis_at({0, 0}).spectrogram(signal, 100.0, no_kwargs, {.add_colorbar = true});
+            fig.axis_at({0, 1}).line_density(lines, no_kwargs, {.resolution = {.rows = 32, .cols = 32}});
+        }, 30), tolerance));
+    };
+
+    "lifetime_statistics_bands"_test = [] () {
+        streaming_quantiles quantiles{0.0, 1.0};
+        streaming_moments moments{0.0, 1.0};
+        for (int i = 0; i < 1000; ++i) {
+            quantiles.insert(i*0.01, std::sin(i*0.1));
+            moments.insert(i*0.01, std::sin(i*0.1));
+        }
+        expect(lt(growth_per_iteration([&] () {
+            figure fig;
+            fig.axis().plot_quantile_band(quantiles);
+            fig.axis().plot_mean_band(moments);
+        }, 30), tolerance));
+    };
+
+    "lifetime_profile"_test = [] () {
+        expect(lt(growth_per_iteration([] () {
+            const auto report = profile([] () {
+                figure fig;
+                fig.axis().plot(std::vector{1.0, 2.0, 3.0});
+            }, {.max_functions = 5});
+            expect(eq(report.functions.size(), std::size_t{5}));
+        }, 30), tolerance));
+    };
+
+    "lifetime_pdf_report"_test = [] () {
+        expect(lt(growth_per_iteration([] () {
+            pdf_report report{"lifetime_report.pdf"};
+            for (int page = 0; page < 2; ++page) {
+                figure fig;
+                fig.axis().plot(std::vector{1.0, 2.0, 3.0});
+                report.append(fig);
+            }
+        }, 20), tolerance));
+    };
+
+    "lifetime_save_progressive"_test = [] () {
+        // each iteration renders in a subprocess, so use fewer iterations
+        expect(lt(growth_per_iteration([] () {
+            figure fig;
+            fig.axis().plot(std::vector{1.0, 2.0, 3.0});
+            auto save = fig.save_progressive("lifetime_preview.png", "lifetime_full.png", {.preview_dpi = 10, .dpi = 20});
+            save.wait();
+        }, 10, 2), tolerance));
+    };
+
+    return 0;
+}
@@ -4,11 +4,30 @@
 #include <stdlib.h>
 #include <filesystem>
 #include <algorithm>
+#include <numeric>
 #include <list>
+#include <thread>
+#include <chrono>
+#include <optional>
+#include <tuple>
+#include <cmath>
+#include <numbers>
 
 #include <boost/ut.hpp>
 
 #include <cpplot/cpplot.hpp>
+#include <cpplot/complex.hpp>
+#include <cpplot/line_density.hpp>
+#include <cpplot/lod.hpp>
+#include <cpplot/mosaic.hpp>
+#include <cpplot/spectrogram.hpp>
+#include <cpplot/statistics.hpp>
+#include <cpplot/triple_buffer.hpp>
+
+#if defined(CPPLOT_COMPILED_LIB) && defined(Py_PYTHON_H)
+    static_assert(false, "With CPPLOT_COMPILED_LIB, the cpplot headers must not include Python.h");
+#endif
+#include <cpplot/python.hpp>
 
 using namespace boost::ut;
 
@@ -34,6 +53,10 @@ std::string as_string(const cpplot::pyobject& obj) {
     return result;
 }
 
+cpplot::pyobject first_item(const cpplot::pyobject& list) {
+    return cpplot::pyobject{Py_XNewRef(PyList_GetItem(list.get(), 0))};
+}
+
 template<std::invocable F>
 bool raises_pyerror(F&& f) {
     bool has_error = false;
@@ -43,6 +66,20 @@ bool raises_pyerror(F&& f) {
     return has_error;
 }
 
+//! Return the peak growth of the memory traced by python's tracemalloc during the given action
+template<std::invocable F>
+long long traced_peak_growth(F&& action) {
+    using namespace cpplot;
+    static const auto tracemalloc = pyobject::from(PyImport_ImportModule("tracemalloc"));
+    py_invoke(tracemalloc, "start");
+    py_invoke(tracemalloc, "reset_peak");
+    const auto before = detail::from_pyobject<std::tuple<long long, long long>>(py_invoke(tracemalloc, "get_traced_memory"));
+    action();
+    const auto after = detail::from_pyobject<std::tuple<long long, long long>>(py_invoke(tracemalloc, "get_traced_memory"));
+    py_invoke(tracemalloc, "stop");
+    return std::get<1>(after) - std::get<0>(before);
+}
+
 struct test_point {
     double x;
     double y;
@@ -165,6 +202,25 @@ int main() {
         }));
     };
 
+    "plot_function"_test = [&] () {
+        expect(!raises_pyerror([] () {
+            auto lines = figure{}.axis().plot_function([] (double x) { return std::sin(x); }, 0.0, 10.0);
+            expect(eq(PyList_Size(lines.get()), Py_ssize_t{1}));
+            auto x = py_invoke(first_item(lines), "get_xdata");
+            expect(gt(PyObject_Length(x.get()), Py_ssize_t{33}));
+        }));
+    };
+
+    "plot_linear_function_uses_initial_samples_only"_test = [&] () {
+        expect(!raises_pyerror([] () {
+            auto lines = figure{}.axis().plot_function([] (double x) { return 2.0*x; }, 0.0, 1.0, 1e-3, no_kwargs, {
+                .initial_samples = 5
+            });
+            auto x = py_invoke(first_item(lines), "get_xdata");
+            expect(eq(PyObject_Length(x.get()), Py_ssize_t{5}));
+        }));
+    };
+
     "bar_plot"_test = [&] () {
         expect(!raises_pyerror([] () {
             expect(figure{}.axis().bar(std::vector<int>{1, 2, 3}));
@@ -230,6 +286,14 @@ int main() {
         }));
     };
 
+    "plot_image_from_callback"_test = [&] () {
+        expect(!raises_pyerror([] () {
+            expect(figure{}.axis().imshow(grid{.rows = 20, .cols = 30}, [] (const grid_location& loc) {
+                return static_cast<double>(loc.row)*static_cast<double>(loc.col);
+            }, kwargs("cmap"_kw = "Greys"), {.add_colorbar = true}));
+        }));
+    };
+
     "fill_from_std_array"_test = [] () {
         expect(!raises_pyerror([] () {
             figure f;
@@ -246,6 +310,660 @@ int main() {
         }));
     };
 
+    "fill_simplified"_test = [] () {
+        expect(!raises_pyerror([] () {
+            std::vector<test_point> circle;
+            for (int i = 0; i < 100000; ++i)
+                circle.push_back({std::cos(2.0*std::numbers::pi*i/100000.0), std::sin(2.0*std::numbers::pi*i/100000.0)});
+            figure f;
+            auto polygons = f.axis().fill(circle, no_kwargs, {.simplify_tolerance = 0.5});
+            auto corners = py_invoke(first_item(polygons), "get_xy");
+            expect(lt(PyObject_Length(corners.get()), Py_ssize_t{10000}));
+        }));
+    };
+
+    "plot_simplified"_test = [] () {
+        expect(!raises_pyerror([] () {
+            std::vector<double> values(100000, 1.0);
+            values[50000] = 2.0;
+            figure f;
+            auto lines = f.axis().plot(values, no_kwargs, plot_options{.simplify_tolerance = 0.5});
+            auto x = py_invoke(first_item(lines), "get_xdata");
+            expect(lt(PyObject_Length(x.get()), Py_ssize_t{10}));
+        }));
+    };
+
+    "plot_clipped_to_view"_test = [] () {
+        expect(!raises_pyerror([] () {
+            std::vector<double> values(100000);
+            std::iota(values.begin(), values.end(), 0.0);
+            figure f;
+            f.axis().set_x_limits(10.0, 20.0);
+            auto lines = f.axis().plot(values, values, no_kwargs, plot_options{.clip_to_view = true});
+            auto x = py_invoke(first_item(lines), "get_xdata");
+            expect(eq(PyObject_Length(x.get()), Py_ssize_t{13}));
+        }));
+    };
+
+    "plot_level_of_detail_series"_test = [] () {
+        expect(!raises_pyerror([] () {
+            std::vector<double> values(1000000);
+            std::iota(values.begin(), values.end(), 0.0);
+            figure f;
+            auto line = first_item(f.axis().plot(lod_series{values}));
+            expect(lt(PyObject_Length(py_invoke(line, "get_xdata").get()), Py_ssize_t{10000}));
+            f.axis().set_x_limits(100.0, 200.0);
+            expect(eq(PyObject_Length(py_invoke(line, "get_xdata").get()), Py_ssize_t{103}));
+        }));
+    };
+
+    "line_density"_test = [] () {
+        expect(!raises_pyerror([] () {
+            std::vector<std::vector<std::array<double, 2>>> lines(500);
+            for (std::size_t i = 0; i < lines.size(); ++i)
+                for (int j = 0; j <= 100; ++j)
+                    lines[i].push_back({j*0.01, std::sin(j*0.1 + static_cast<double>(i)*0.01)});
+            figure f;
+            auto image = f.axis().line_density(lines, kwargs("cmap"_kw = "inferno"), {
+                .resolution = {.rows = 64, .cols = 128},
+                .add_colorbar = true
+            });
+            auto size = py_invoke(image, "get_size");
+            expect(eq(PyLong_AsLong(pyobject{PySequence_GetItem(size.get(), 0)}.get()), 64l));
+            expect(eq(PyLong_AsLong(pyobject{PySequence_GetItem(size.get(), 1)}.get()), 128l));
+        }));
+    };
+
+    "line_density_off_screen_segments"_test = [] () {
+        expect(!raises_pyerror([] () {
+            const auto painted = [] (const std::vector<std::array<double, 2>>& line) {
+                figure f;
+                f.axis().set_x_limits(0.0, 1.0);
+                f.axis().set_y_limits(0.0, 1.0);
+                auto image = f.axis().line_density(std::vector<std::vector<std::array<double, 2>>>{line}, no_kwargs, {.resolution = {.rows = 16, .cols = 16}});
+                return detail::from_pyobject<double>(py_invoke(py_invoke(image, "get_array"), "sum"));
+            };
+            expect(eq(painted({{1e20, 0.5}, {2e20, 0.5}}), 0.0));
+            expect(eq(painted({{-2e20, 0.5}, {-1e20, 0.5}}), 0.0));
+            expect(eq(painted({{0.5, 1e300}, {0.6, 2e300}}), 0.0));
+            expect(eq(painted({{2.0, 0.0}, {0.0, 2.0}}), 0.0));
+            expect(lt(std::abs(painted({{-1e20, 0.5}, {1e20, 0.5}}) - 16.0), 1e-3));
+            expect(lt(std::abs(painted({{0.5, -1e300}, {0.5, 1e300}}) - 16.0), 1e-3));
+        }));
+    };
+
+    "ecdf"_test = [] () {
+        expect(!raises_pyerror([] () {
+            std::vector<double> values(100000);
+            std::iota(values.begin(), values.end(), 0.0);
+            std::ranges::reverse(values);
+            figure f;
+            auto line = first_item(f.axis().ecdf(values, no_kwargs, {.points = 101, .tail_points_per_decade = 0}));
+            const auto x = detail::from_pyobject<std::vector<double>>(py_invoke(line, "get_xdata"));
+            const auto p = detail::from_pyobject<std::vector<double>>(py_invoke(line, "get_ydata"));
+            expect(eq(x.size(), std::size_t{101}));
+            expect(eq(x.front(), 0.0));
+            expect(eq(x[50], 49999.0));
+            expect(eq(x.back(), 99999.0));
+            expect(eq(p[50], 0.5));
+            expect(eq(p.back(), 1.0));
+        }));
+    };
+
+    "ecdf_with_tail_emphasis"_test = [] () {
+        expect(!raises_pyerror([] () {
+            std::vector<double> values(100000);
+            std::iota(values.begin(), values.end(), 0.0);
+            figure f;
+            auto line = first_item(f.axis().ecdf(values, no_kwargs, {.points = 11, .complementary = true}));
+            const auto x = detail::from_pyobject<std::vector<double>>(py_invoke(line, "get_xdata"));
+            expect(std::ranges::is_sorted(x));
+            expect(std::ranges::find(x, 99989.0) != x.end());
+            expect(std::ranges::find(x, 99998.0) != x.end());
+        }));
+    };
+
+    "quantile_sketch"_test = [] () {
+        quantile_sketch a, b;
+        for (int i = 0; i < 500000; ++i) {
+            a.insert(static_cast<double>(i));
+            b.insert(static_cast<double>(i + 500000));
+        }
+        expect(eq(a.count(), std::size_t{500000}));
+        expect(lt(std::abs(a.quantile(0.5) - 250000.0), 10000.0));
+        a.merge(b);
+        expect(eq(a.count(), std::size_t{1000000}));
+        expect(lt(std::abs(a.quantile(0.5) - 500000.0), 20000.0));
+        expect(lt(std::abs(a.quantile(0.99) - 990000.0), 20000.0));
+        expect(std::isnan(quantile_sketch{}.quantile(0.5)));
+    };
+
+    "plot_quantile_band"_test = [] () {
+        expect(!raises_pyerror([] () {
+            streaming_quantiles q1{0.0, 1.0}, q2{0.0, 1.0};
+            for (int i = 0; i < 10000; ++i) {
+                q1.insert(i*0.001, static_cast<double>(i % 100));
+                q2.insert(20.0 + i*0.001, static_cast<double>(i % 100));
+            }
+            q1.merge(q2);
+            expect(eq(q1.bucket_count(), std::size_t{30}));
+            expect(eq(q1[15].count(), std::size_t{0}));
+            figure f;
+            auto lines = f.axis().plot_quantile_band(q1, kwargs("linestyle"_kw = "--"), {.quantiles = {0.99, 0.5}});
+            expect(eq(PyObject_Length(lines.get()), Py_ssize_t{2}));
+        }));
+        expect(throws([] () { streaming_quantiles{0.0, 1.0}.merge(streaming_quantiles{0.0, 2.0}); }));
+    };
+
+    "streaming_quantiles_invalid_positions"_test = [] () {
+        streaming_quantiles quantiles{0.0, 1.0};
+        quantiles.insert(std::numeric_limits<double>::infinity(), 1.0);
+        quantiles.insert(std::numeric_limits<double>::quiet_NaN(), 1.0);
+        expect(eq(quantiles.bucket_count(), std::size_t{0}));
+        expect(throws([&] () { quantiles.insert(1e20, 1.0); }));
+        expect(eq(quantiles.bucket_count(), std::size_t{0}));
+    };
+
+    "complex_values"_test = [] () {
+        expect(!raises_pyerror([] () {
+            const auto value = detail::to_pyobject(std::complex<double>{1.0, -2.0});
+            expect(eq(PyComplex_RealAsDouble(value.get()), 1.0));
+            expect(eq(PyComplex_ImagAsDouble(value.get()), -2.0));
+
+            const auto array = detail::to_pyobject(std::vector<std::complex<float>>{{1.0f, 2.0f}, {3.0f, 4.0f}});
+            expect(eq(as_string(py_invoke(detail::get_attribute(array, "dtype"), "__str__")), std::string{"complex64"}));
+            expect(eq(detail::from_pyobject<std::size_t>(py_invoke(array, "__len__")), std::size_t{2}));
+        }));
+    };
+
+    "plot_complex_projections"_test = [] () {
+        expect(!raises_pyerror([] () {
+            const std::vector<std::complex<double>> values{{3.0, 4.0}, {0.0, 1.0}, {-1.0, 0.0}, {0.0, 0.0}};
+            figure f;
+            const auto ydata = [&] (complex_projection projection) {
+                auto line = first_item(f.axis().plot(project(values, projection)));
+                return detail::from_pyobject<std::vector<double>>(py_invoke(line, "get_ydata"));
+            };
+            expect(eq(ydata(complex_projection::magnitude), std::vector{5.0, 1.0, 1.0, 0.0}));
+            expect(eq(ydata(complex_projection::real), std::vector{3.0, 0.0, -1.0, 0.0}));
+            expect(eq(ydata(complex_projection::imag), std::vector{4.0, 1.0, 0.0, 0.0}));
+            const auto phase = ydata(complex_projection::phase);
+            expect(lt(std::abs(phase[1] - std::numbers::pi/2.0), 1e-12) and lt(std::abs(phase[2] - std::numbers::pi), 1e-12));
+            const auto decibels = ydata(complex_projection::decibels);
+            expect(lt(std::abs(decibels[0] - 20.0*std::log10(5.0)), 1e-12));
+            expect(std::isinf(decibels[3]));
+        }));
+    };
+
+    "imshow_complex_projection"_test = [] () {
+        expect(!raises_pyerror([] () {
+            std::vector<std::vector<std::complex<float>>> image(20, std::vector<std::complex<float>>(30, {1.0f, 1.0f}));
+            image[3][4] = {0.0f, 0.0f};
+            figure f;
+            auto img = f.axis().imshow(project(image, complex_projection::decibels), no_kwargs, {.add_colorbar = true});
+            auto size = py_invoke(img, "get_size");
+            expect(eq(PyLong_AsLong(pyobject{PySequence_GetItem(size.get(), 0)}.get()), 20l));
+            expect(eq(PyLong_AsLong(pyobject{PySequence_GetItem(size.get(), 1)}.get()), 30l));
+
+            image[5].pop_back();
+            expect(throws([&] () { f.axis().imshow(project(image, complex_projection::magnitude)); }));
+        }));
+    };
+
+    "complex_projection_of_rvalues"_test = [] () {
+        expect(!raises_pyerror([] () {
+            auto magnitudes = project(std::vector<std::complex<double>>{{3.0, 4.0}, {0.0, 2.0}}, complex_projection::magnitude);
+            expect(eq(std::ranges::size(magnitudes), std::size_t{2}));
+            expect(eq(std::vector<double>(magnitudes.begin(), magnitudes.end()), std::vector{5.0, 2.0}));
+
+            figure f;
+            auto line = first_item(f.axis().plot(std::move(magnitudes)));
+            expect(eq(detail::from_pyobject<std::vector<double>>(py_invoke(line, "get_ydata")), std::vector{5.0, 2.0}));
+
+            using row = std::vector<std::complex<float>>;
+            auto image = project(std::vector<row>(4, row(5, {0.0f, 1.0f})), complex_projection::imag);
+            for (auto projected_row : image)
+                expect(std::ranges::all_of(projected_row, [] (float v) { return v == 1.0f; }));
+            auto img = f.axis().imshow(image);
+            auto size = py_invoke(img, "get_size");
+            expect(eq(PyLong_AsLong(pyobject{PySequence_GetItem(size.get(), 1)}.get()), 5l));
+
+            auto lazy = project(
+                std::views::iota(0, 3) | std::views::transform([] (int i) { return std::complex<double>{0.0, double(i)}; }),
+                complex_projection::imag
+            );
+            expect(eq(std::vector<double>(lazy.begin(), lazy.end()), std::vector{0.0, 1.0, 2.0}));
+        }));
+    };
+
+    "spectrogram"_test = [] () {
+        expect(!raises_pyerror([] () {
+            const double sample_rate = 8000.0;
+            std::vector<double> signal(8000);
+            for (std::size_t i = 0; i < signal.size(); ++i)
+                signal[i] = std::sin(2.0*std::numbers::pi*1000.0*static_cast<double>(i)/sample_rate);
+            figure f;
+            auto image = f.axis().spectrogram(signal, sample_rate, kwargs("cmap"_kw = "magma"), {
+                .frame_size = 256,
+                .overlap = 128,
+                .window = window_function::hann
+            });
+            auto size = py_invoke(image, "get_size");
+            expect(eq(PyLong_AsLong(pyobject{PySequence_GetItem(size.get(), 0)}.get()), 129l));
+            expect(eq(PyLong_AsLong(pyobject{PySequence_GetItem(size.get(), 1)}.get()), 61l));
+
+            const auto peaks = detail::from_pyobject<std::vector<std::size_t>>(
+                py_invoke(py_invoke(image, "get_array"), "argmax", no_args, kwargs("axis"_kw = 0))
+            );
+            expect(std::ranges::all_of(peaks, [] (std::size_t bin) { return bin == 32; }));
+            const auto extent = detail::from_pyobject<std::vector<double>>(py_invoke(image, "get_extent"));
+            expect(lt(std::abs(extent[3] - 4015.625), 1e-9));
+        }));
+    };
+
+    "running_moments"_test = [] () {
+        running_moments a, b;
+        for (double v : {1.0, 2.0, 3.0})
+            a.insert(v);
+        for (double v : {4.0, 5.0})
+            b.insert(v);
+        a.merge(b);
+        expect(eq(a.count(), std::size_t{5}));
+        expect(lt(std::abs(a.mean() - 3.0), 1e-12));
+        expect(lt(std::abs(a.variance() - 2.5), 1e-12));
+        expect(std::isnan(running_moments{}.mean()));
+    };
+
+    "plot_mean_band"_test = [] () {
+        expect(!raises_pyerror([] () {
+            std::vector<streaming_moments> shards(4, streaming_moments{0.0, 1.0});
+            detail::parallel_for(shards.size(), [&] (std::size_t shard) {
+                for (int i = 0; i < 1000; ++i)
+                    shards[shard].insert(static_cast<double>(i % 10), static_cast<double>(i % 10) + ((i/10) % 2 ? 1.0 : -1.0));
+            });
+            streaming_moments moments{0.0, 1.0};
+            for (const auto& shard : shards)
+                moments.merge(shard);
+            expect(eq(moments.bucket_count(), std::size_t{10}));
+            expect(eq(moments[3].count(), std::size_t{400}));
+
+            figure f;
+            auto line = first_item(f.axis().plot_mean_band(moments, kwargs("color"_kw = "k"), {.standard_deviations = 2.0}));
+            const auto y = detail::from_pyobject<std::vector<double>>(py_invoke(line, "get_ydata"));
+            expect(lt(std::abs(y[3] - 3.0), 1e-12));
+        }));
+    };
+
+    "streaming_moments_concurrent_inserts"_test = [] () {
+        expect(!raises_pyerror([] () {
+            streaming_moments moments{0.0, 1.0};
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 8; ++t)
+                threads.emplace_back([&moments, t] () {
+                    for (int i = 0; i < 10000; ++i)
+                        moments.insert(static_cast<double>(i % 10), static_cast<double>(t));
+                });
+            // reading (and thereby merging the shards) may overlap with the inserts
+            for (int i = 0; i < 10; ++i)
+                expect(le(moments[0].count(), std::size_t{8000}));
+            for (auto& thread : threads)
+                thread.join();
+
+            expect(eq(moments.bucket_count(), std::size_t{10}));
+            expect(eq(moments[9].count(), std::size_t{8000}));
+            expect(lt(std::abs(moments[9].mean() - 3.5), 1e-12));
+
+            const streaming_moments copy = moments;
+            moments.insert(0.5, 1.0);
+            expect(eq(copy[0].count(), std::size_t{8000}));
+            expect(eq(moments[0].count(), std::size_t{8001}));
+
+            figure f;
+            auto line = first_item(f.axis().plot_mean_band(moments));
+            expect(eq(detail::from_pyobject<std::vector<double>>(py_invoke(line, "get_ydata")).size(), std::size_t{10}));
+        }));
+    };
+
+    "streaming_moments_invalid_positions"_test = [] () {
+        streaming_moments moments{0.0, 1.0};
+        moments.insert(std::numeric_limits<double>::infinity(), 1.0);
+        moments.insert(-std::numeric_limits<double>::infinity(), 1.0);
+        moments.insert(std::numeric_limits<double>::quiet_NaN(), 1.0);
+        moments.insert(-1e300, 1.0);
+        expect(eq(moments.bucket_count(), std::size_t{0}));
+        expect(throws([&] () { moments.insert(1e300, 1.0); }));
+        expect(throws([&] () { moments.insert(static_cast<double>(streaming_moments::max_bucket_count), 1.0); }));
+        expect(eq(moments.bucket_count(), std::size_t{0}));
+        moments.insert(2.5, 1.0);
+        expect(eq(moments.bucket_count(), std::size_t{3}));
+    };
+
+    "bucket_series_outliers_are_stored_sparsely"_test = [] () {
+        expect(!raises_pyerror([] () {
+            streaming_quantiles quantiles{0.0, 1.0};
+            quantiles.insert(0.5, 1.0);
+            quantiles.insert(static_cast<double>(std::size_t{1} << 40), 2.0);
+            expect(eq(quantiles.buckets().size(), std::size_t{2}));
+            expect(eq(quantiles.bucket_count(), (std::size_t{1} << 40) + 1));
+            expect(eq(quantiles[1].count(), std::size_t{0}));
+
+            figure f;
+            auto lines = f.axis().plot_quantile_band(quantiles, no_kwargs, {.quantiles = {0.5}});
+            const auto y = detail::from_pyobject<std::vector<double>>(py_invoke(first_item(lines), "get_ydata"));
+            expect(eq(y.size(), std::size_t{3}));  // the gap is marked by a NaN value
+            expect(eq(y[0], 1.0) and std::isnan(y[1]) and eq(y[2], 2.0));
+        }));
+    };
+
+    "persistent_buffer"_test = [] () {
+        expect(!raises_pyerror([] () {
+            persistent_buffer<double> x{100}, y{100};
+            x.assign(std::vector{0.0, 1.0, 2.0});
+            y.assign(std::vector{1.0, 4.0, 9.0});
+            figure f;
+            auto line = first_item(f.axis().plot(x, y));
+            auto ydata = detail::from_pyobject<std::vector<double>>(py_invoke(line, "get_ydata"));
+            expect(eq(ydata.size(), std::size_t{100}));
+            expect(eq(ydata[2], 9.0) and std::isnan(ydata[3]));
+
+            const auto array = detail::to_pyobject(y);
+            y.assign(std::vector{5.0, 6.0});
+            expect(eq(array.get(), detail::to_pyobject(y).get()));
+            expect(eq(detail::from_pyobject<double>(py_invoke(array, "__getitem__", args(0))), 5.0));
+            py_invoke(line, "set_data", args(x, y));
+            ydata = detail::from_pyobject<std::vector<double>>(py_invoke(line, "get_ydata"));
+            expect(eq(ydata[1], 6.0) and std::isnan(ydata[2]));
+            expect(throws([&] () { y.resize(101); }));
+
+            persistent_buffer<float> image{grid{.rows = 10, .cols = 20}};
+            std::ranges::fill(image.values(), 1.0f);
+            auto img = f.axis().imshow(image);
+            py_invoke(img, "set_data", args(image));
+        }));
+    };
+
+    "persistent_buffer_conversion_does_not_allocate"_test = [] () {
+        expect(!raises_pyerror([] () {
+            persistent_buffer<double> buffer{100000};
+            const std::vector<double> values(100000, 1.0);
+            const auto array = detail::to_pyobject(buffer);
+            const long long buffer_growth = traced_peak_growth([&] () {
+                for (int frame = 0; frame < 10; ++frame) {
+                    buffer.assign(values);
+                    expect(eq(detail::to_pyobject(buffer).get(), array.get()));
+                }
+            });
+            const long long vector_growth = traced_peak_growth([&] () { detail::to_pyobject(values); });
+            expect(lt(buffer_growth, 1024ll));
+            expect(gt(vector_growth, 100000ll));
+        }));
+    };
+
+    "persistent_buffer_frame_loop"_test = [] () {
+        expect(!raises_pyerror([] () {
+            figure f;
+            persistent_buffer<double> x{1000}, y{1000};
+            persistent_buffer<float> image{grid{.rows = 20, .cols = 30}};
+            auto line = first_item(f.axis().plot(x, y));
+            auto img = f.axis().imshow(image);
+            f.axis().set_x_limits(0.0, 1000.0);
+            f.axis().set_y_limits(0.0, 100.0);
+            auto canvas = detail::get_attribute(f.get_pyobject(), "canvas");
+            refresh(line); // the first refresh compiles the python helper
+            py_invoke(canvas, "draw");
+            const auto vertices = detail::get_attribute(line, "_xy");
+
+            std::vector<double> indices(1000);
+            std::iota(indices.begin(), indices.end(), 0.0);
+            for (int frame = 0; frame < 10; ++frame) {
+                const std::size_t size = frame % 2 ? 1000 : 500;
+                x.assign(std::span{indices}.first(size));
+                y.assign(std::vector<double>(size, static_cast<double>(frame)));
+                std::ranges::fill(image.values(), static_cast<float>(frame));
+                image.values()[0] = std::numeric_limits<float>::quiet_NaN();
+                expect(lt(traced_peak_growth([&] () { refresh(line); refresh(img); }), 256ll));
+                py_invoke(canvas, "draw");
+
+                // the line draws from its original vertex array, which has been updated in place
+                expect(eq(detail::get_attribute(line, "_xy").get(), vertices.get()));
+                const auto path = py_invoke(py_invoke(line, "get_path"), "__getattribute__", args("vertices"));
+                expect(eq(detail::from_pyobject<double>(py_invoke(path, "item", args(size - 1, 1))), static_cast<double>(frame)));
+                if (size < 1000)
+                    expect(std::isnan(detail::from_pyobject<double>(py_invoke(path, "item", args(size, 1)))));
+                const auto values = py_invoke(img, "get_array");
+                expect(eq(detail::from_pyobject<double>(py_invoke(values, "item", args(1, 1))), static_cast<double>(frame)));
+                expect(detail::from_pyobject<bool>(py_invoke(py_invoke(values, "__getattribute__", args("mask")), "item", args(0, 0))));
+            }
+
+            // artists whose data has been replaced are rebound on refresh
+            py_invoke(line, "set_data", args(std::vector{1.0}, std::vector{1.0}));
+            refresh(line);
+            expect(eq(detail::from_pyobject<std::size_t>(py_invoke(py_invoke(line, "get_ydata"), "__len__")), std::size_t{1000}));
+        }));
+    };
+
+    "triple_buffer_handoff"_test = [] () {
+        struct frame { std::size_t id = 0; std::vector<std::size_t> values = std::vector<std::size_t>(256, 0); };
+        constexpr std::size_t frame_count = 100000;
+        triple_buffer<frame> frames;
+        std::thread producer{[&] () {
+            for (std::size_t id = 1; id <= frame_count; ++id) {
+                frames.back().id = id;
+                std::ranges::fill(frames.back().values, id);
+                frames.publish();
+            }
+        }};
+
+        bool consistent = true;
+        std::size_t last_id = 0, updates = 0;
+        while (last_id < frame_count) {
+            if (!frames.update())
+                continue;
+            const auto& current = frames.front();
+            consistent = consistent && current.id > last_id && std::ranges::all_of(current.values, [&] (std::size_t v) {
+                return v == current.id;
+            });
+            last_id = current.id;
+            ++updates;
+        }
+        producer.join();
+        expect(consistent);
+        expect(eq(last_id, frame_count));
+        expect(le(updates, frame_count));
+        expect(!frames.update());
+    };
+
+    "imshow_mosaic"_test = [] () {
+        expect(!raises_pyerror([] () {
+            std::vector<std::vector<std::vector<int>>> kernels;
+            std::vector<std::string> labels;
+            for (int k = 0; k < 10; ++k) {
+                kernels.push_back(std::vector<std::vector<int>>(k == 9 ? 2 : 3, std::vector<int>(3, k)));
+                kernels.back()[0][0] = -k;
+                labels.push_back("kernel " + std::to_string(k));
+            }
+            figure f;
+            auto image = f.axis().imshow_mosaic(kernels, kwargs("cmap"_kw = "gray"), {.padding = 1, .labels = labels});
+            auto size = py_invoke(image, "get_size");
+            expect(eq(PyLong_AsLong(pyobject{PySequence_GetItem(size.get(), 0)}.get()), 11l));
+            expect(eq(PyLong_AsLong(pyobject{PySequence_GetItem(size.get(), 1)}.get()), 15l));
+            expect(eq(PyObject_Length(py_invoke(f.axis().get_pyobject(), "__getattribute__", args("texts")).get()), Py_ssize_t{10}));
+
+            auto data = py_invoke(py_invoke(image, "get_array"), "filled", args(-1.0));
+            const auto pixel = [&] (int row, int col) {
+                return detail::from_pyobject<double>(py_invoke(data, "item", args(row, col)));
+            };
+            expect(eq(pixel(0, 4), 0.0) and eq(pixel(1, 4), 1.0) and eq(pixel(9, 4), 1.0));
+            expect(eq(pixel(3, 0), -1.0));
+            expect(eq(pixel(10, 4), -1.0));
+            expect(throws([&] () { f.axis().imshow_mosaic(kernels, no_kwargs, {.labels = {"a"}}); }));
+        }));
+    };
+
+    "imshow_mosaic_of_transform_view"_test = [] () {
+        expect(!raises_pyerror([] () {
+            auto tiles = std::views::iota(0, 4) | std::views::transform([] (int k) {
+                return std::vector<std::vector<double>>(2, std::vector<double>(2, static_cast<double>(k)));
+            });
+            figure f;
+            auto image = f.axis().imshow_mosaic(tiles, no_kwargs, {.columns = 4, .padding = 0, .normalize_tiles = false});
+            auto data = py_invoke(image, "get_array");
+            for (int k = 0; k < 4; ++k)
+                expect(eq(detail::from_pyobject<double>(py_invoke(data, "item", args(1, 2*k + 1))), static_cast<double>(k)));
+        }));
+    };
+
+    "progressive_save"_test = [] () {
+        expect(!raises_pyerror([] () {
+            std::filesystem::remove("preview.png");
+            std::filesystem::remove("full.png");
+            auto fig = std::make_unique<figure>();
+            fig->axis().plot(std::vector<double>{1.0, 2.0, 3.0, 2.0});
+            auto save = fig->save_progressive("preview.png", "full.png", {.preview_dpi = 20, .dpi = 200});
+            expect(std::filesystem::exists("preview.png"));
+            fig.reset();
+            // the render must progress while this thread holds the GIL without executing python code
+            for (int i = 0; i < 600 && !save.ready(); ++i)
+                std::this_thread::sleep_for(std::chrono::milliseconds{100});
+            expect(save.ready());
+            save.wait();
+            expect(save.ready());
+            expect(std::filesystem::exists("full.png"));
+            expect(std::filesystem::file_size("full.png") > std::filesystem::file_size("preview.png"));
+
+            std::filesystem::remove("full.png");
+            std::filesystem::remove("other_full.png");
+            figure other;
+            save = other.save_progressive("preview.png", "full.png");
+            save = other.save_progressive("preview.png", "other_full.png");
+            expect(std::filesystem::exists("full.png"));
+            save.wait();
+            expect(std::filesystem::exists("other_full.png"));
+
+            auto failing = other.save_progressive("preview.png", "non_existing_folder/full.png");
+            expect(throws([&] () { failing.wait(); }));
+        }));
+    };
+
+    "callback_as_tick_formatter"_test = [] () {
+        expect(!raises_pyerror([] () {
+            figure f;
+            f.axis().plot(std::vector{1.0, 2.0, 3.0});
+            auto x_axis = f.axis().py_invoke("get_xaxis");
+            py_invoke(x_axis, "set_major_formatter", args(callback([] (double x, std::optional<int>) {
+                return "x=" + std::to_string(static_cast<int>(x));
+            })));
+            auto formatter = py_invoke(x_axis, "get_major_formatter");
+            expect(eq(as_string(py_invoke(formatter, "__call__", args(2.0, 0))), std::string{"x=2"}));
+            expect(eq(as_string(py_invoke(formatter, "__call__", args(3.0, pyobject::none()))), std::string{"x=3"}));
+        }));
+    };
+
+    "callback_as_event_handler"_test = [] () {
+        expect(!raises_pyerror([] () {
+            int calls = 0;
+            figure f;
+            auto callbacks = py_invoke(f.axis().get_pyobject(), "__getattribute__", args("callbacks"));
+            py_invoke(callbacks, "connect", args("ylim_changed", callback([&] (const pyobject&) { ++calls; })));
+            f.axis().set_y_limits(0.0, 1.0);
+            f.axis().set_y_limits(0.0, 2.0);
+            expect(eq(calls, 2));
+        }));
+    };
+
+    "callback_exception__should_raise_pyerror"_test = [] () {
+        expect(raises_pyerror([] () {
+            figure f;
+            auto callbacks = py_invoke(f.axis().get_pyobject(), "__getattribute__", args("callbacks"));
+            py_invoke(callbacks, "connect", args("ylim_changed", callback([] (const pyobject&) {
+                throw std::runtime_error("error in callback");
+            })));
+            f.axis().set_y_limits(0.0, 1.0);
+        }));
+    };
+
+    "callback_non_standard_exception__should_raise_pyerror"_test = [] () {
+        expect(raises_pyerror([] () {
+            figure f;
+            auto callbacks = py_invoke(f.axis().get_pyobject(), "__getattribute__", args("callbacks"));
+            py_invoke(callbacks, "connect", args("ylim_changed", callback([] (const pyobject&) {
+                throw 42;
+            })));
+            f.axis().set_y_limits(0.0, 1.0);
+        }));
+    };
+
+    "annotate_many"_test = [] () {
+        expect(!raises_pyerror([] () {
+            figure f;
+            auto annotations = f.axis().annotate_many(
+                std::vector<test_point>{{0.1, 0.1}, {0.5, 0.5}, {0.9, 0.9}},
+                std::vector<std::string>{"a", "b", "c"},
+                kwargs("color"_kw = "red")
+            );
+            expect(eq(PyList_Size(annotations.get()), Py_ssize_t{3}));
+        }));
+    };
+
+    "annotate_many_culling_outside_of_view"_test = [] () {
+        expect(!raises_pyerror([] () {
+            figure f;
+            f.axis().set_x_limits(0.0, 1.0);
+            f.axis().set_y_limits(0.0, 1.0);
+            auto annotations = f.axis().annotate_many(
+                std::vector<std::array<double, 2>>{{1e20, 0.5}, {-1e300, 1e300}, {0.5, 0.5}, {0.5, -2.0}},
+                std::vector<std::string>{"far", "farther", "visible", "below"},
+                no_kwargs,
+                {.cull_overlaps = true}
+            );
+            expect(eq(PyList_Size(annotations.get()), Py_ssize_t{1}));
+        }));
+    };
+
+    "annotate_many_culling_on_log_axis"_test = [] () {
+        expect(!raises_pyerror([] () {
+            figure f;
+            f.axis().py_invoke("set_xscale", args("log"));
+            f.axis().set_x_limits(1.0, 1e6);
+            f.axis().set_y_limits(0.0, 1.0);
+            std::vector<std::array<double, 2>> positions;
+            for (double x = 1.0; x < 1e6; x *= 10.0)
+                positions.push_back({x, 0.5});
+            auto annotations = f.axis().annotate_many(
+                positions, std::vector<std::string>(positions.size(), "x"), no_kwargs, {.cull_overlaps = true}
+            );
+            expect(eq(PyList_Size(annotations.get()), static_cast<Py_ssize_t>(positions.size())));
+        }));
+    };
+
+    "annotate_many_culling_uses_fontsize_kwarg"_test = [] () {
+        expect(!raises_pyerror([] () {
+            figure f;
+            f.axis().set_x_limits(0.0, 1.0);
+            f.axis().set_y_limits(0.0, 1.0);
+            const std::vector<std::array<double, 2>> positions{{0.4, 0.5}, {0.5, 0.5}};
+            const std::vector<std::string> labels{"ab", "cd"};
+            const auto count = [&] (const auto& kwargs) {
+                return PyList_Size(f.axis().annotate_many(positions, labels, kwargs, {.cull_overlaps = true}).get());
+            };
+            expect(eq(count(kwargs("fontsize"_kw = 5)), Py_ssize_t{2}));
+            expect(eq(count(kwargs("fontsize"_kw = 40)), Py_ssize_t{1}));
+            expect(eq(count(kwargs("fontsize"_kw = "xx-small")), Py_ssize_t{2}));
+        }));
+    };
+
+    "annotate_many_with_overlap_culling"_test = [] () {
+        expect(!raises_pyerror([] () {
+            figure f;
+            std::vector<std::array<double, 2>> positions(1000, {0.5, 0.5});
+            std::vector<std::string> labels(1000, "label");
+            positions.push_back({0.1, 0.1});
+            labels.push_back("other");
+            auto annotations = f.axis().annotate_many(positions, labels, no_kwargs, {.cull_overlaps = true});
+            expect(eq(PyList_Size(annotations.get()), Py_ssize_t{2}));
+        }));
+    };
+
     "axis_title"_test = [&] () {
         expect(!raises_pyerror([] () {
             auto fig = figure();
@@ -265,6 +983,63 @@ int main() {
         expect(std::filesystem::exists("some_figure.png"));
     };
 
+    "profile_figure_save"_test = [&] () {
+        std::filesystem::remove("profile.pstats");
+        const auto report = profile([] () {
+            figure fig;
+            fig.axis().plot(std::vector{1.0, 2.0, 3.0});
+            fig.save_to("profiled_figure.png");
+        }, {.pstats_file = "profile.pstats", .max_functions = 10});
+        expect(eq(report.functions.size(), std::size_t{10}));
+        expect(std::filesystem::exists("profile.pstats"));
+        expect(std::ranges::any_of(report.artists, [] (const auto& entry) {
+            return entry.artist == "Line2D" && entry.calls >= 1;
+        }));
+    };
+
+    "memory_policy"_test = [&] () {
+        set_memory_policy({.collect_after_close = true, .trim_interval = 2});
+        expect(eq(get_memory_policy().trim_interval, std::size_t{2}));
+        expect(!raises_pyerror([] () {
+            for (int i = 0; i < 4; ++i) {
+                figure f;
+                f.axis().plot(std::vector{1.0, 2.0, 3.0}, kwargs("label"_kw = "label " + std::to_string(i)));
+                f.axis().add_legend();
+                f.save_to("memory_policy_figure.png");
+            }
+        }));
+        const auto report = trim_memory();
+        expect(gt(report.python_blocks_before, std::size_t{0}));
+        expect(gt(report.python_blocks_after, std::size_t{0}));
+        set_memory_policy({});
+        expect(eq(get_number_of_figures(), std::size_t{0}));
+    };
+
+    "gc_pause"_test = [&] () {
+        {
+            auto pause = pause_gc();
+            expect(eq(PyGC_IsEnabled(), 0));
+        }
+        expect(eq(PyGC_IsEnabled(), 1));
+    };
+
+    "pdf_report"_test = [&] () {
+        std::filesystem::remove("report.pdf");
+        {
+            pdf_report report{"report.pdf"};
+            for (int i = 0; i < 3; ++i) {
+                figure page;
+                page.axis().plot(std::vector{1.0, 2.0, static_cast<double>(i)});
+                page.set_title("page " + std::to_string(i));
+                report.append(page);
+                expect(eq(get_number_of_figures(), std::size_t{0}));
+            }
+            report.append(figure{});
+            expect(eq(report.page_count(), std::size_t{4}));
+        }
+        expect(std::filesystem::exists("report.pdf"));
+    };
+
     "figure_matrix_single_row"_test = [&] () {
         expect(!raises_pyerror([] () {
             figure fig_matrix{{1, 2}};
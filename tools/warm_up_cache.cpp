@@ -0,0 +1,33 @@
+// SPDX-FileCopyrightText: 2024 Dennis Gläser <dennis.a.glaeser@gmail.com>
+// SPDX-License-Identifier: MIT
+
+// Prepares matplotlib's font cache and config for fast cold starts, e.g. in a container build step:
+//
+//     RUN cpplot-warm-up-cache /opt/mplconfig
+//     ENV MPLCONFIGDIR=/opt/mplconfig
+//
+// Alternatively, configure cpplot with -DCPPLOT_MPLCONFIGDIR=/opt/mplconfig, in which case this tool and all
+// applications linking against cpplot use that directory by default (MPLCONFIGDIR takes precedence if set).
+// Note that matplotlib ignores the directory if it is not writable by the user running the application.
+
+#include <iostream>
+#include <filesystem>
+
+#include <cpplot/cpplot.hpp>
+
+int main(int argc, char** argv) {
+    if (argc > 2) {
+        std::cerr << "Usage: " << argv[0] << " [MPLCONFIGDIR]" << std::endl;
+        return 1;
+    }
+    if (argc == 2) {
+        std::filesystem::create_directories(argv[1]);
+        cpplot::detail::set_environment_variable("MPLCONFIGDIR", std::filesystem::absolute(argv[1]).string());
+    }
+
+    const auto info = cpplot::warm_up_cache();
+    std::cout << "config directory: " << info.config_dir << "\n"
+              << "cache directory:  " << info.cache_dir << "\n"
+              << "backend:          " << info.backend << std::endl;
+    return 0;
+}